@@ -0,0 +1,168 @@
+#ifndef INCLUDE_NISHE_ACTIVEINDICES_H_
+#define INCLUDE_NISHE_ACTIVEINDICES_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+namespace nishe {
+
+/*
+ * The indices of the cells waiting to be sown by the refiner.
+ *
+ * A marker per index makes contains() O(1) and keeps an index from being
+ * queued twice. The order they come out in is one of
+ *   LIFO           the last index pushed (what the refiner always did)
+ *   FIFO           the first index pushed
+ *   SMALLEST_FIRST the index of the smallest cell, the smallest index on ties
+ * Each order only depends on the indices and cell sizes, so a trace is
+ * consistent as long as it is always compared under the same order.
+ *
+ * A queued cell that gets split keeps its index but shrinks, so push() is
+ * called again with its new size. SMALLEST_FIRST keeps a heap of
+ * (size, index) and skips the entries whose size has gone stale.
+ */
+class ActiveIndices {
+ public:
+  enum Order {
+    LIFO, FIFO, SMALLEST_FIRST
+  };
+
+  ActiveIndices() :
+    order_(LIFO), head_(0), size_(0) {
+  }
+
+  // the order should only be changed while empty
+  void set_order(Order order) {
+    order_ = order;
+  }
+
+  Order order() const {
+    return order_;
+  }
+
+  // makes room for the indices 0 ... n - 1, forgetting what was queued
+  void resize(int n) {
+    queued_.assign(n, false);
+    sizes_.assign(n, 0);
+    entries_.clear();
+    head_ = 0;
+    size_ = 0;
+  }
+
+  // releases the memory, leaving room for no indices
+  void trim() {
+    std::vector<bool>().swap(queued_);
+    std::vector<int>().swap(sizes_);
+    std::vector<entry>().swap(entries_);
+    head_ = 0;
+    size_ = 0;
+  }
+
+  // queues k, whose cell has cell_size elements, or updates its size
+  void push(int k, int cell_size) {
+    if (queued_[k]) {
+      if (order_ == SMALLEST_FIRST && sizes_[k] != cell_size) {
+        sizes_[k] = cell_size;
+        push_entry(k, cell_size);
+      }
+
+      return;
+    }
+
+    queued_[k] = true;
+    sizes_[k] = cell_size;
+    size_ += 1;
+
+    push_entry(k, cell_size);
+  }
+
+  // removes and returns the next index, must not be empty
+  int pop() {
+    int k = -1;
+
+    if (order_ == LIFO) {
+      k = entries_.back().second;
+      entries_.pop_back();
+    } else if (order_ == FIFO) {
+      k = entries_[head_].second;
+      head_ += 1;
+    } else {
+      // skip what was already popped or has shrunk since
+      do {
+        std::pop_heap(entries_.begin(), entries_.end(), std::greater<entry>());
+        k = entries_.back().second;
+
+        bool is_current = queued_[k] && sizes_[k] == entries_.back().first;
+        entries_.pop_back();
+
+        if (is_current) {
+          break;
+        }
+      } while (true);
+    }
+
+    queued_[k] = false;
+    size_ -= 1;
+
+    if (size_ == 0) {
+      entries_.clear();
+      head_ = 0;
+    }
+
+    return k;
+  }
+
+  bool contains(int k) const {
+    return queued_[k];
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  int size() const {
+    return size_;
+  }
+
+  void clear() {
+    for (size_t i = head_; i < entries_.size(); i++) {
+      queued_[entries_[i].second] = false;
+    }
+
+    entries_.clear();
+    head_ = 0;
+    size_ = 0;
+  }
+
+ private:
+  // a cell size and index
+  typedef std::pair<int, int> entry;
+
+  Order order_;
+
+  std::vector<bool> queued_;
+  std::vector<int> sizes_;  // the latest size pushed for each queued index
+
+  std::vector<entry> entries_;
+  int head_;  // where FIFO pops from
+  int size_;  // the number of distinct indices queued
+
+  void push_entry(int k, int cell_size) {
+    entries_.push_back(entry(cell_size, k));
+
+    if (order_ == SMALLEST_FIRST) {
+      std::push_heap(entries_.begin(), entries_.end(), std::greater<entry>());
+    }
+  }
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_ACTIVEINDICES_H_
@@ -0,0 +1,58 @@
+#ifndef INCLUDE_NISHE_ARCINDEX_H_
+#define INCLUDE_NISHE_ARCINDEX_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <cstddef>
+#include <vector>
+
+namespace nishe {
+
+/*
+ * A hash table from an arc (u, v) to the position of v in u's nbhd.
+ * Vertices are taken as size_t so that this does not depend on Graph.h.
+ *
+ * Graph keeps one of these while it is being built so that checking whether
+ * an arc is already present does not have to scan u's whole nbhd.
+ * Open addressing with linear probing, arcs are never removed.
+ */
+class ArcIndex {
+ public:
+  static const int NOT_FOUND;
+
+  ArcIndex();
+
+  // returns the position stored for (u, v), NOT_FOUND if there is none
+  int find(size_t u, size_t v) const;
+
+  // stores pos for (u, v), replacing the old position if there was one
+  void insert(size_t u, size_t v, int pos);
+
+  // forgets every arc and releases the table
+  void clear();
+
+  // makes room for arc_count arcs without rehashing
+  void reserve(size_t arc_count);
+
+  size_t size() const;
+
+ private:
+  struct Slot {
+    size_t u;
+    size_t v;
+    int pos;  // NOT_FOUND when the slot is empty
+  };
+
+  std::vector<Slot> slots_;
+  size_t size_;
+
+  size_t slot_of(size_t u, size_t v) const;
+  void rehash(size_t slot_count);
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_ARCINDEX_H_
@@ -0,0 +1,69 @@
+#ifndef INCLUDE_NISHE_ATTRSUMSORT_H_
+#define INCLUDE_NISHE_ATTRSUMSORT_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Graph.h>
+#include <nishe/DirectedGraph.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace nishe {
+
+/*
+ * The kernels that sort the vertices of a cell by their attr_sums when the
+ * refiner splits it.
+ *
+ * The attr_sum type picks the kernel at compile time: the overloads for the
+ * integer attr_sums (vertex_t of BasicGraph, InOutBoth of the directed
+ * graphs) turn each attr_sum into an integer key and LSD radix sort the
+ * keys, going to an insertion sort for small cells. Any other attr_sum is
+ * sorted by comparison. Every kernel leaves the same cells; only the order
+ * of the vertices with equal attr_sums may differ.
+ */
+
+// a vertex with the key it is sorted on
+struct KeyedVertex {
+  unsigned long long key;
+  int v;
+};
+
+// the scratch space of the radix sorts, kept by the refiner between cells
+struct AttrSumSortBuffer {
+  std::vector<KeyedVertex> keyed;
+  std::vector<KeyedVertex> temp;
+};
+
+template<typename attr_sum>
+struct AttrSumLess {
+  const std::vector<attr_sum> *attr_sums_ptr;
+
+  explicit AttrSumLess(const std::vector<attr_sum> *attr_sums_ptr) :
+    attr_sums_ptr(attr_sums_ptr) {
+  }
+
+  bool operator()(int u, int v) const {
+    return (*attr_sums_ptr)[u] < (*attr_sums_ptr)[v];
+  }
+};
+
+// sorts the vertices first ... last - 1 by their attr_sums
+template<typename attr_sum>
+void sort_by_attr_sum(int *first, int *last,
+    const std::vector<attr_sum> &attr_sums, AttrSumSortBuffer *buffer_ptr) {
+  std::sort(first, last, AttrSumLess<attr_sum>(&attr_sums));
+}
+
+void sort_by_attr_sum(int *first, int *last,
+    const std::vector<vertex_t> &attr_sums, AttrSumSortBuffer *buffer_ptr);
+
+void sort_by_attr_sum(int *first, int *last,
+    const std::vector<InOutBoth> &attr_sums, AttrSumSortBuffer *buffer_ptr);
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_ATTRSUMSORT_H_
@@ -15,11 +15,11 @@ namespace nishe {
  * of neighbors for each vertex.
  *
  * The vertex_degree type is just a vertex, and the degree sums
- * are nonzero integers.
+ * are nonzero integers (a vertex wide, since they are at most a degree).
  *
  * Intended for simple symmetric graphs (although allowing self loops).
  */
-class BasicGraph: public Graph<vertex_t, size_t, size_t> {
+class BasicGraph: public Graph<BasicGraph, vertex_t, vertex_t, vertex_t> {
  public:
   // adds the edge u, v to the graph
   // or does nothing if the edge is there already (returns false)
@@ -27,13 +27,18 @@ class BasicGraph: public Graph<vertex_t, size_t, size_t> {
 
   bool add_arc(vertex_t u, vertex_t v);
 
-  vertex_t nbhr_vertex(const BasicGraph::nbhr &nbhr) const {
+  // decode a nbhr without needing a graph
+  static vertex_t vertex_of(const BasicGraph::nbhr &nbhr) {
     return nbhr;
   }
 
-  BasicGraph::attr nbhr_attr(const BasicGraph::nbhr &nbhr) const {
+  static BasicGraph::attr attr_of(const BasicGraph::nbhr &nbhr) {
     return 1;
   }
+
+  static BasicGraph::nbhr make_nbhr(vertex_t v, BasicGraph::attr weight) {
+    return v;
+  }
 };
 
 }  // namespace nishe
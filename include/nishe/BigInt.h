@@ -0,0 +1,54 @@
+#ifndef INCLUDE_NISHE_BIGINT_H_
+#define INCLUDE_NISHE_BIGINT_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace nishe {
+
+/*
+ * A nonnegative integer of any size, for the orders of groups, which
+ * overflow 64 bits long before the groups get hard to work with.
+ *
+ * Only what a group order needs is here: multiplying by a machine sized
+ * factor, comparing and printing in decimal. The digits are stored base
+ * 10^9, least significant first, so printing is just padding each one.
+ */
+class BigInt {
+ public:
+  BigInt(unsigned long x = 0);
+
+  BigInt &operator*=(unsigned long x);
+
+  // -1, 0 or 1 as this is smaller than, equal to or larger than b
+  int cmp(const BigInt &b) const;
+
+  bool operator==(const BigInt &b) const {
+    return cmp(b) == 0;
+  }
+
+  bool operator!=(const BigInt &b) const {
+    return cmp(b) != 0;
+  }
+
+  // the decimal digits
+  std::string to_string() const;
+
+ private:
+  static const unsigned int DIGIT_BASE;
+
+  // never empty, and the last digit is only 0 for 0 itself
+  std::vector<unsigned int> digits_;
+};
+
+std::ostream &operator<<(std::ostream &out, const BigInt &x);
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_BIGINT_H_
@@ -0,0 +1,671 @@
+#ifndef INCLUDE_NISHE_CANONIZER_INL_H_
+#define INCLUDE_NISHE_CANONIZER_INL_H_
+
+/*
+    Copyright 2010 Greg Tener
+    Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Canonizer.h>
+#include <nishe/Graph-inl.h>
+#include <nishe/Refiner-inl.h>
+#include <nishe/Threads.h>
+#include <nishe/WorkStealingDeque.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace nishe {
+
+template<typename graph_t, typename trace_t>
+const int Canonizer<graph_t, trace_t>::NO_BACKJUMP = -1;
+
+template<typename graph_t, typename trace_t>
+const int Canonizer<graph_t, trace_t>::NOT_STARTED = -1;
+
+template<typename graph_t, typename trace_t>
+Canonizer<graph_t, trace_t>::Canonizer(int thread_count) :
+  thread_count_(thread_count), shared_(NULL), root_level_(0), path_depth_(0),
+      has_first_leaf_(false), has_best_leaf_(false),
+      backjump_depth_(NO_BACKJUMP), node_count_(0) {
+  if (thread_count_ < 1) {
+    fprintf(stderr, "Error Error Examine: %s\n",
+        "a search needs at least one thread");
+    exit(1);
+  }
+
+  // without threads the parallel search would only take turns
+  if (!has_threads()) {
+    thread_count_ = 1;
+  }
+}
+
+// whether gamma fixes each of path[0] ... path[depth - 1]
+inline bool fixes_path(const vector<int> &gamma, const vector<int> &path,
+    int depth) {
+  for (int d = 0; d < depth; d++) {
+    if (gamma[path[d]] != path[d]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::canonize(const graph_t &G) {
+  PartitionNest pi;
+
+  pi.unit(G.vertex_count());
+
+  canonize(G, pi);
+}
+
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::canonize(const graph_t &G,
+    const PartitionNest &pi) {
+  int n = G.vertex_count();
+
+  pi_ = pi;
+  has_first_leaf_ = false;
+  has_best_leaf_ = false;
+  backjump_depth_ = NO_BACKJUMP;
+  node_count_ = 0;
+
+  generators_.clear();
+  group_.reset(n);
+
+  // a path individualizes at most n vertices
+  best_traces_.resize(n + 1);
+  on_first_.resize(n + 1);
+  on_best_.resize(n + 1);
+  target_cells_.resize(n + 1);
+  node_orbits_.resize(n + 1);
+  node_generator_counts_.resize(n + 1);
+  path_.resize(n);
+  leaf_labels_.resize(n);
+
+  for (int d = 0; d < best_traces_.size(); d++) {
+    best_traces_[d].clear();
+  }
+
+  if (n == 0) {
+    best_labels_.clear();
+    best_graph_.clear();
+    orbits_.reset(0);
+    orbit_representatives_.clear();
+    return;
+  }
+
+  // the root refines pi on a level of its own
+  pi_.advance_level();
+  refiner_.refine(G, &pi_, &best_traces_[0]);
+  node_count_ += 1;
+
+  if (thread_count_ == 1) {
+    search(G, 0);
+  } else {
+    search_parallel(G);
+  }
+
+  // the orbits of the whole group
+  orbits_.reset(n);
+
+  for (int g = 0; g < group_.generator_count(); g++) {
+    orbits_.unite_all(&group_.generator(g)[0]);
+  }
+
+  orbit_representatives_.resize(n);
+
+  for (int u = 0; u < n; u++) {
+    orbit_representatives_[u] = orbits_.find(u);
+  }
+}
+
+/*
+ * Goes through the subtree of the node at depth, whose partition pi_ is
+ * refined and whose trace is no larger than the smallest one at depth.
+ * Returns early when jumping back to a shallower node.
+ */
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::search(const graph_t &G, int depth) {
+  if (pi_.is_discrete()) {
+    visit_leaf(G, depth);
+    return;
+  }
+
+  int k = pi_.first_nontrivial_index();
+  vector<int> &target_cell = target_cells_[depth];
+
+  // the children are copied, refining them moves the cell's elements
+  target_cell.assign(pi_.elements() + k,
+      pi_.elements() + k + pi_.cell_size(k));
+  node_generator_counts_[depth] = NOT_STARTED;
+
+  for (int i = 0; i < target_cell.size(); i++) {
+    int u = target_cell[i];
+
+    // a child in the orbit of one searched has an isomorphic subtree
+    if (i > 0 && is_in_searched_orbit(depth, i)) {
+      continue;
+    }
+
+    search_child(G, depth, k, u);
+
+    if (node_generator_counts_[depth] != NOT_STARTED) {
+      node_orbits_[depth].mark(u);
+    }
+
+    if (backjump_depth_ != NO_BACKJUMP) {
+      if (backjump_depth_ < depth) {
+        return;
+      }
+
+      backjump_depth_ = NO_BACKJUMP;
+    }
+  }
+}
+
+/*
+ * Individualizes u, of the target cell at k of the node at depth, and goes
+ * through the subtree of that child unless its trace is larger.
+ */
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::search_child(const graph_t &G, int depth,
+    int k, int u) {
+  int level = pi_.level();
+
+  path_[depth] = u;
+
+  pi_.advance_level();
+  pi_.breakout(u);
+  node_count_ += 1;
+
+  bool is_searched;
+
+  if (shared_ == NULL) {
+    // only the individualized vertex's cell (now at k) has to be sown
+    int cmp = refiner_.refine(G, &pi_, &best_traces_[depth + 1], k);
+
+    // a smaller trace beats everything found below the old one
+    if (cmp == -1) {
+      drop_best_below(depth + 1);
+    }
+
+    is_searched = cmp != 1;
+  } else {
+    is_searched = refine_task_node(G, depth + 1, k);
+  }
+
+  if (is_searched) {
+    search(G, depth + 1);
+  }
+
+  pi_.recover_level(level);
+}
+
+// drops the smallest traces below depth and the best leaf
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::drop_best_below(int depth) {
+  for (int d = depth + 1; d < best_traces_.size(); d++) {
+    best_traces_[d].clear();
+  }
+
+  has_best_leaf_ = false;
+}
+
+/*
+ * Returns true if the i-th child of the node at depth is in the orbit of a
+ * child searched before it, under the strong generators of group_ that fix
+ * the vertices individualized above the node (and so fix the node).
+ *
+ * The orbits of each depth are only started once a node there has a child
+ * to check, and then the new strong generators are merged in as the search
+ * finds them. On the first path the generators fixing it are a strong
+ * generating set of its stabilizers, so the orbits there are as large as
+ * they get, elsewhere they are of a subgroup.
+ */
+template<typename graph_t, typename trace_t>
+bool Canonizer<graph_t, trace_t>::is_in_searched_orbit(int depth, int i) {
+  pull_generators();
+
+  if (known_generator_count() == 0) {
+    return false;
+  }
+
+  Orbits &orbits = node_orbits_[depth];
+  const vector<int> &target_cell = target_cells_[depth];
+  int &generator_count = node_generator_counts_[depth];
+
+  if (generator_count == NOT_STARTED) {
+    orbits.reset(group_.degree());
+    generator_count = 0;
+
+    // nothing was skipped before
+    for (int j = 0; j < i; j++) {
+      orbits.mark(target_cell[j]);
+    }
+  }
+
+  for (; generator_count < known_generator_count(); generator_count++) {
+    const vector<int> &gamma = known_generator(generator_count);
+
+    if (fixes_path(gamma, path_, depth)) {
+      orbits.unite_all(&gamma[0]);
+    }
+  }
+
+  return orbits.is_marked(target_cell[i]);
+}
+
+/*
+ * Relabels G by the discrete partition, keeping it if it is the smallest,
+ * or taking the automorphism if it is the first or the best leaf's graph.
+ */
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::visit_leaf(const graph_t &G, int depth) {
+  for (int u = 0; u < G.vertex_count(); u++) {
+    leaf_labels_[u] = pi_.position_of(u);
+  }
+
+  leaf_graph_.assign_relabeled(G, &leaf_labels_[0]);
+
+  if (!has_first_leaf_) {
+    first_labels_ = leaf_labels_;
+    first_graph_ = leaf_graph_;
+    first_path_.assign(path_.begin(), path_.begin() + depth);
+    has_first_leaf_ = true;
+
+    // the first path is a base, as only the identity fixes it
+    group_.reset(G.vertex_count(), first_path_);
+  } else if (leaf_graph_.cmp(first_graph_) == 0) {
+    add_automorphism(G, first_labels_, first_path_, depth);
+    return;
+  }
+
+  // a task's leaf may only have been reached for the first path's traces
+  if (shared_ != NULL && !on_best_[depth]) {
+    return;
+  }
+
+  int cmp = has_best_leaf_ ? leaf_graph_.cmp(best_graph_) : -1;
+
+  if (cmp == -1) {
+    best_labels_ = leaf_labels_;
+    best_graph_ = leaf_graph_;
+    best_path_.assign(path_.begin(), path_.begin() + depth);
+    has_best_leaf_ = true;
+  } else if (cmp == 0) {
+    add_automorphism(G, best_labels_, best_path_, depth);
+  }
+}
+
+/*
+ * Keeps the automorphism taking the leaf labeled other_labels (reached by
+ * other_path) to the current leaf, and jumps back to where their paths
+ * part.
+ */
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::add_automorphism(const graph_t &G,
+    const vector<int> &other_labels, const vector<int> &other_path,
+    int depth) {
+  const int *elements = pi_.elements();
+  vector<int> gamma(G.vertex_count());
+
+  for (int u = 0; u < G.vertex_count(); u++) {
+    gamma[u] = elements[other_labels[u]];
+  }
+
+  if (!is_automorphism(G, &gamma[0])) {
+    fprintf(stderr, "Error Error Examine: leaves with equal graphs did not "
+        "give an automorphism\n");
+    exit(1);
+  }
+
+  if (shared_ == NULL) {
+    if (group_.add_generator(&gamma[0])) {
+      generators_.push_back(gamma);
+    }
+  } else {
+    // the group is the one of the thread that started the search
+    Canonizer &owner = *shared_->owner;
+
+    shared_->mutex.lock();
+
+    if (owner.group_.add_generator(&gamma[0])) {
+      owner.generators_.push_back(gamma);
+      atomic_store(&shared_->published_count,
+          owner.group_.generator_count());
+    }
+
+    shared_->mutex.unlock();
+  }
+
+  int part_depth = 0;
+
+  while (part_depth < depth && part_depth < other_path.size()
+      && path_[part_depth] == other_path[part_depth]) {
+    part_depth += 1;
+  }
+
+  /*
+   * In a parallel search, a leaf of another task is only known to have been
+   * searched below the path node where the two part, not the first path's
+   * stabilizers, so its task is finished without jumping back out of it.
+   */
+  if (shared_ != NULL && part_depth < path_depth_) {
+    return;
+  }
+
+  backjump_depth_ = part_depth;
+}
+
+/*
+ * The search with thread_count_ threads. This thread goes down the first
+ * path, then every child off it (other than the first path's) is a task,
+ * the subtree below it searched by one thread. The tasks are dealt out to
+ * the threads' deques deepest first, the deepest at the bottom, as their
+ * subtrees are the smallest and give automorphisms soonest.
+ *
+ * Each thread is a copy of this Canonizer, with its own pi_, refiner and
+ * smallest traces (which start as the first path's), and keeps its own
+ * best leaf, the smallest of which is taken at the end. The automorphisms
+ * go into this thread's group_, under shared_->mutex, and the threads
+ * copy the new strong generators (see pull_generators()) when they need
+ * them.
+ *
+ * A task is skipped when its child is in the orbit of a child already
+ * taken at its first path node, under the strong generators fixing the
+ * path above the node, as the taken child's subtree is searched anyway.
+ * So a task taken is searched whatever traces its thread has seen: the
+ * nodes of its subtree are kept while they have the first path's traces,
+ * which is where the automorphisms fixing the path above it are, or the
+ * smallest ones (see refine_task_node()).
+ */
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::search_parallel(const graph_t &G) {
+  int depth = 0;
+
+  root_level_ = pi_.level();
+
+  while (!pi_.is_discrete()) {
+    int k = pi_.first_nontrivial_index();
+
+    target_cells_[depth].assign(pi_.elements() + k,
+        pi_.elements() + k + pi_.cell_size(k));
+    path_[depth] = target_cells_[depth][0];
+
+    pi_.advance_level();
+    pi_.breakout(path_[depth]);
+    node_count_ += 1;
+
+    refiner_.refine(G, &pi_, &best_traces_[depth + 1], k);
+    depth += 1;
+  }
+
+  visit_leaf(G, depth);
+  path_depth_ = depth;
+  first_traces_ = best_traces_;
+  on_first_.assign(on_first_.size(), true);
+  on_best_.assign(on_best_.size(), true);
+
+  SharedSearch shared;
+  WorkStealingDeque<PathTask> *deques =
+      new WorkStealingDeque<PathTask>[thread_count_];
+  int task_count = 0;
+
+  shared.owner = this;
+  shared.published_count = 0;
+  shared.path_orbits.resize(depth);
+  shared.path_generator_counts.assign(depth, 0);
+  shared.deques = deques;
+
+  for (int d = 0; d < depth; d++) {
+    shared.path_orbits[d].reset(G.vertex_count());
+    shared.path_orbits[d].mark(first_path_[d]);
+
+    for (int i = 1; i < target_cells_[d].size(); i++) {
+      deques[task_count % thread_count_].push(
+          PathTask(d, target_cells_[d][i]));
+      task_count += 1;
+    }
+  }
+
+  // the other threads start from copies of this one at the first leaf
+  vector<Canonizer *> workers(thread_count_);
+  vector<WorkerStart> starts(thread_count_);
+
+  shared_ = &shared;
+  pulled_generators_.clear();
+  workers[0] = this;
+
+  for (int t = 1; t < thread_count_; t++) {
+    workers[t] = new Canonizer(*this);
+    workers[t]->node_count_ = 0;
+  }
+
+  for (int t = 0; t < thread_count_; t++) {
+    starts[t].worker_ptr = workers[t];
+    starts[t].G_ptr = &G;
+    starts[t].index = t;
+  }
+
+  run_threads(run_worker, &starts, "to search");
+
+  // the best leaf of all the threads
+  for (int t = 1; t < thread_count_; t++) {
+    Canonizer &worker = *workers[t];
+
+    if (worker.has_best_leaf_ && (!has_best_leaf_
+        || cmp_best_leaf(worker) > 0)) {
+      best_traces_.swap(worker.best_traces_);
+      best_labels_.swap(worker.best_labels_);
+      best_path_.swap(worker.best_path_);
+      best_graph_ = worker.best_graph_;
+      has_best_leaf_ = true;
+    }
+
+    node_count_ += worker.node_count_;
+    delete workers[t];
+  }
+
+  shared_ = NULL;
+  delete[] deques;
+}
+
+template<typename graph_t, typename trace_t>
+void *Canonizer<graph_t, trace_t>::run_worker(void *arg) {
+  WorkerStart *start = static_cast<WorkerStart *>(arg);
+
+  start->worker_ptr->work(*start->G_ptr, start->index);
+
+  return NULL;
+}
+
+// runs tasks, stealing when out of its own, until there are none left
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::work(const graph_t &G, int index) {
+  PathTask task;
+
+  while (true) {
+    bool is_taken = shared_->deques[index].pop(&task);
+
+    for (int j = 1; j < thread_count_ && !is_taken; j++) {
+      is_taken = shared_->deques[(index + j) % thread_count_].steal(&task);
+    }
+
+    // no task is added once the search starts
+    if (!is_taken) {
+      return;
+    }
+
+    if (claim(task)) {
+      run_task(G, task);
+    }
+  }
+}
+
+/*
+ * Returns true if the task's child is not in the orbit of one taken at its
+ * first path node before, and takes it.
+ */
+template<typename graph_t, typename trace_t>
+bool Canonizer<graph_t, trace_t>::claim(const PathTask &task) {
+  shared_->mutex.lock();
+
+  const PermutationGroup &group = shared_->owner->group_;
+  Orbits &orbits = shared_->path_orbits[task.depth];
+  int &generator_count = shared_->path_generator_counts[task.depth];
+
+  for (; generator_count < group.generator_count(); generator_count++) {
+    const vector<int> &gamma = group.generator(generator_count);
+
+    if (fixes_path(gamma, first_path_, task.depth)) {
+      orbits.unite_all(&gamma[0]);
+    }
+  }
+
+  bool is_claimed = !orbits.is_marked(task.vertex);
+
+  if (is_claimed) {
+    orbits.mark(task.vertex);
+  }
+
+  shared_->mutex.unlock();
+
+  return is_claimed;
+}
+
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::run_task(const graph_t &G,
+    const PathTask &task) {
+  reach_path_node(G, task.depth);
+  search_child(G, task.depth, pi_.first_nontrivial_index(), task.vertex);
+  backjump_depth_ = NO_BACKJUMP;
+}
+
+/*
+ * Brings pi_ to the first path node at depth, going back up or refining
+ * down the first path from where it is. The nodes on the way have the first
+ * path's traces, and are checked against this thread's smallest ones.
+ */
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::reach_path_node(const graph_t &G,
+    int depth) {
+  if (path_depth_ > depth) {
+    pi_.recover_level(root_level_ + depth);
+    path_depth_ = depth;
+  }
+
+  while (path_depth_ < depth) {
+    int d = path_depth_;
+    int k = pi_.first_nontrivial_index();
+
+    path_[d] = first_path_[d];
+
+    pi_.advance_level();
+    pi_.breakout(first_path_[d]);
+    node_count_ += 1;
+
+    scratch_trace_.clear();
+    refiner_.refine(G, &pi_, &scratch_trace_, k);
+
+    on_first_[d + 1] = true;
+    on_best_[d + 1] = on_best_[d] && take_best_trace(d + 1);
+
+    path_depth_ += 1;
+  }
+}
+
+/*
+ * Refines the node at depth of a task's subtree, whose vertex
+ * individualized has its cell at k, returning whether it is searched: if it
+ * has the first path's traces so far, or the smallest ones.
+ *
+ * Below a node without the first path's traces, only the smallest traces
+ * matter, and the node is refined against them as in search_child().
+ * Otherwise its whole trace is needed to compare with both.
+ */
+template<typename graph_t, typename trace_t>
+bool Canonizer<graph_t, trace_t>::refine_task_node(const graph_t &G,
+    int depth, int k) {
+  if (!on_first_[depth - 1]) {
+    int cmp = refiner_.refine(G, &pi_, &best_traces_[depth], k);
+
+    if (cmp == -1) {
+      drop_best_below(depth);
+    }
+
+    on_first_[depth] = false;
+    on_best_[depth] = cmp != 1;
+
+    return on_best_[depth];
+  }
+
+  scratch_trace_.clear();
+  refiner_.refine(G, &pi_, &scratch_trace_, k);
+
+  on_first_[depth] = scratch_trace_.cmp(first_traces_[depth]) == 0;
+  on_best_[depth] = on_best_[depth - 1] && take_best_trace(depth);
+
+  return on_first_[depth] || on_best_[depth];
+}
+
+/*
+ * Compares scratch_trace_, of the node at depth, with the smallest trace
+ * there, taking it (and dropping the ones below) if it is smaller. Returns
+ * false if it is larger.
+ */
+template<typename graph_t, typename trace_t>
+bool Canonizer<graph_t, trace_t>::take_best_trace(int depth) {
+  int cmp = best_traces_[depth].is_clear() ? -1
+      : scratch_trace_.cmp(best_traces_[depth]);
+
+  if (cmp == -1) {
+    best_traces_[depth] = scratch_trace_;
+    drop_best_below(depth);
+  }
+
+  return cmp != 1;
+}
+
+// copies the strong generators other threads added since the last time
+template<typename graph_t, typename trace_t>
+void Canonizer<graph_t, trace_t>::pull_generators() {
+  if (shared_ == NULL || atomic_load(&shared_->published_count)
+      == static_cast<int>(pulled_generators_.size())) {
+    return;
+  }
+
+  shared_->mutex.lock();
+
+  const PermutationGroup &group = shared_->owner->group_;
+
+  for (int g = pulled_generators_.size(); g < group.generator_count(); g++) {
+    pulled_generators_.push_back(group.generator(g));
+  }
+
+  shared_->mutex.unlock();
+}
+
+/*
+ * Compares the best leaf of this search to the one of b, by their traces
+ * depth by depth and then by their graphs.
+ */
+template<typename graph_t, typename trace_t>
+int Canonizer<graph_t, trace_t>::cmp_best_leaf(const Canonizer &b) const {
+  for (int d = 0; d < best_traces_.size(); d++) {
+    int cmp = best_traces_[d].cmp(b.best_traces_[d]);
+
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+
+  return best_graph_.cmp(b.best_graph_);
+}
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_CANONIZER_INL_H_
@@ -0,0 +1,251 @@
+#ifndef INCLUDE_NISHE_CANONIZER_H_
+#define INCLUDE_NISHE_CANONIZER_H_
+
+/*
+    Copyright 2010 Greg Tener
+    Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/CompressedGraph.h>
+#include <nishe/Orbits.h>
+#include <nishe/PartitionNest.h>
+#include <nishe/PermutationGroup.h>
+#include <nishe/Refiner.h>
+#include <nishe/RefineTraceValue.h>
+#include <nishe/Threads.h>
+#include <nishe/WorkStealingDeque.h>
+
+#include <vector>
+
+using std::vector;
+
+namespace nishe {
+
+/*
+ * Finds a canonical labeling of a graph G, colored by an ordered partition
+ * pi of its vertices, by individualization and refinement.
+ *
+ * The root of the search tree is pi refined, and the children of a node
+ * individualize each vertex of its first nontrivial cell (the target cell)
+ * and refine from it, down to the discrete partitions at the leaves. A leaf
+ * labels each vertex by its position, and the canonical leaf is the one
+ * whose traces are the smallest (level by level), then whose relabeled
+ * graph is the smallest. Isomorphic (G, pi) get the same canonical graph.
+ *
+ * The smallest trace seen at each level is kept, and every node is refined
+ * against it, so a node whose trace turns out larger is cut off as soon as
+ * the refiner sees that, along with its whole subtree. A smaller trace
+ * replaces the kept one, and then the traces below it and the best leaf so
+ * far are dropped.
+ *
+ * Two leaves with the same relabeled graph give an automorphism of (G, pi),
+ * mapping one leaf's labeling to the other's. The search compares each
+ * leaf with the first one and the best one, keeps the automorphisms found
+ * as generators(), and then jumps back to where the leaf's path leaves the
+ * path of the leaf it matched, as the rest of that subtree is the image of
+ * one already searched.
+ *
+ * The automorphisms go into a PermutationGroup whose base starts with the
+ * first path, so its strong generators fixing the first path down to a
+ * node generate the node's stabilizer. At every node, a child is skipped
+ * when a child already searched is in its orbit under the strong
+ * generators fixing the vertices individualized above the node. The group
+ * (and its order) and the orbits reported are of the automorphisms found,
+ * which generate Aut(G, pi).
+ *
+ * With more than one thread, the subtrees hanging off the first path are
+ * searched in parallel (see search_parallel()). The canonical graph is
+ * the same, but the labeling may be another one giving it, and the
+ * generators and node count depend on the order the threads went in.
+ * A build without threads (see Threads.h) always searches with one.
+ */
+template<typename graph_t, typename trace_t = RefineTraceValue<graph_t> >
+class Canonizer {
+ public:
+  // searches with thread_count threads
+  explicit Canonizer(int thread_count = 1);
+
+  // the refiner of the search, to set its order or invariant
+  Refiner<graph_t, trace_t> &get_refiner() {
+    return refiner_;
+  }
+
+  // searches for the canonical labeling of G colored by pi (or uncolored)
+  void canonize(const graph_t &G, const PartitionNest &pi);
+  void canonize(const graph_t &G);
+
+  // labeling()[u] is the canonical label of u
+  const vector<int> &labeling() const {
+    return best_labels_;
+  }
+
+  // G relabeled by labeling(), with its nbhds sorted
+  const CompressedGraph<graph_t> &canonical_graph() const {
+    return best_graph_;
+  }
+
+  // the automorphisms found, gamma[u] is the image of u under each, leaving
+  // out the ones in the group of those before
+  const vector<vector<int> > &generators() const {
+    return generators_;
+  }
+
+  // the group generated by generators(), group().order() is |Aut(G, pi)|
+  const PermutationGroup &group() const {
+    return group_;
+  }
+
+  // orbits()[u] is the smallest vertex in u's orbit
+  const vector<int> &orbits() const {
+    return orbit_representatives_;
+  }
+
+  int orbit_count() const {
+    return orbits_.orbit_count();
+  }
+
+  // the nodes refined in the last search, the leaves included
+  long node_count() const {
+    return node_count_;
+  }
+
+  int thread_count() const {
+    return thread_count_;
+  }
+
+ private:
+  static const int NO_BACKJUMP;
+  static const int NOT_STARTED;
+
+  // the subtree of the child vertex of the first path node at depth
+  struct PathTask {
+    PathTask(int task_depth = 0, int task_vertex = 0) :
+      depth(task_depth), vertex(task_vertex) {
+    }
+
+    int depth;
+    int vertex;
+  };
+
+  // what the threads of a parallel search share
+  struct SharedSearch {
+    Mutex mutex;
+
+    // the thread that started the search, whose group_ is the one kept
+    Canonizer *owner;
+
+    // owner->group_.generator_count(), read without the mutex
+    int published_count;
+
+    // the children taken at each first path node, with the strong
+    // generators merged into them
+    vector<Orbits> path_orbits;
+    vector<int> path_generator_counts;
+
+    WorkStealingDeque<PathTask> *deques;
+  };
+
+  struct WorkerStart {
+    Canonizer *worker_ptr;
+    const graph_t *G_ptr;
+    int index;
+  };
+
+  void search(const graph_t &G, int depth);
+  void search_child(const graph_t &G, int depth, int k, int u);
+  void drop_best_below(int depth);
+  bool is_in_searched_orbit(int depth, int i);
+  void visit_leaf(const graph_t &G, int depth);
+  void add_automorphism(const graph_t &G, const vector<int> &other_labels,
+      const vector<int> &other_path, int depth);
+
+  void search_parallel(const graph_t &G);
+  static void *run_worker(void *arg);
+  void work(const graph_t &G, int index);
+  bool claim(const PathTask &task);
+  void run_task(const graph_t &G, const PathTask &task);
+  void reach_path_node(const graph_t &G, int depth);
+  bool refine_task_node(const graph_t &G, int depth, int k);
+  bool take_best_trace(int depth);
+  void pull_generators();
+  int cmp_best_leaf(const Canonizer &b) const;
+
+  // the strong generators this thread knows of
+  int known_generator_count() const {
+    return shared_ == NULL ? group_.generator_count()
+        : pulled_generators_.size();
+  }
+
+  const vector<int> &known_generator(int g) const {
+    return shared_ == NULL ? group_.generator(g) : pulled_generators_[g];
+  }
+
+  int thread_count_;
+
+  // NULL unless this is one of the threads of a parallel search
+  SharedSearch *shared_;
+  vector<vector<int> > pulled_generators_;
+
+  // the level of the root in pi_, and the depth of the first path node
+  // pi_ is at (or below) in a parallel search
+  int root_level_;
+  int path_depth_;
+
+  Refiner<graph_t, trace_t> refiner_;
+
+  // the partition at the current node
+  PartitionNest pi_;
+
+  // the smallest trace seen at each depth
+  vector<trace_t> best_traces_;
+
+  /*
+   * In a parallel search, the traces of the first path, and whether the
+   * node at each depth on the current path has them (is equivalent to the
+   * first path's node so far) or the smallest ones (see refine_task_node()).
+   */
+  vector<trace_t> first_traces_;
+  vector<char> on_first_;
+  vector<char> on_best_;
+  trace_t scratch_trace_;
+
+  // the target cell of the node at each depth on the current path
+  vector<vector<int> > target_cells_;
+
+  // the vertex individualized at each depth on the current path
+  vector<int> path_;
+
+  bool has_first_leaf_;
+  vector<int> first_labels_;
+  vector<int> first_path_;
+  CompressedGraph<graph_t> first_graph_;
+
+  bool has_best_leaf_;
+  vector<int> best_labels_;
+  vector<int> best_path_;
+  CompressedGraph<graph_t> best_graph_;
+
+  // the labels and relabeled graph of the current leaf
+  vector<int> leaf_labels_;
+  CompressedGraph<graph_t> leaf_graph_;
+
+  vector<vector<int> > generators_;
+  PermutationGroup group_;
+
+  // the orbits of the children of the node at each depth on the current
+  // path, and the strong generators merged into them (or NOT_STARTED)
+  vector<Orbits> node_orbits_;
+  vector<int> node_generator_counts_;
+
+  Orbits orbits_;
+  vector<int> orbit_representatives_;
+
+  // the depth the search is jumping back to after an automorphism
+  int backjump_depth_;
+
+  long node_count_;
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_CANONIZER_H_
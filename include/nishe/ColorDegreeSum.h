@@ -0,0 +1,71 @@
+#ifndef INCLUDE_NISHE_COLORDEGREESUM_H_
+#define INCLUDE_NISHE_COLORDEGREESUM_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Graph.h>
+
+namespace nishe {
+
+/*
+ * The degree sum of a graph whose arcs have one of kColors colors
+ * 0 ... kColors - 1: how many nbhrs of each color were sown.
+ *
+ * This is MapDegreeSum for when the weights are known to be a small dense
+ * range, so the counts are an inline array: adding a nbhr is one increment
+ * and comparing two sums never allocates or chases pointers.
+ */
+template<int kColors>
+struct ColorDegreeSum {
+  // increment the color k's counter
+  ColorDegreeSum<kColors> &operator+=(int k) {
+    counts[k] += 1;
+
+    return *this;
+  }
+
+  ColorDegreeSum<kColors> &operator=(int k) {
+    for (int i = 0; i < kColors; i++) {
+      counts[i] = k;
+    }
+
+    return *this;
+  }
+
+  // compare the counts lexicographically
+  bool operator<(const ColorDegreeSum<kColors> &a) const {
+    for (int i = 0; i < kColors; i++) {
+      if (counts[i] < a.counts[i]) {
+        return true;
+      } else if (counts[i] > a.counts[i]) {
+        return false;
+      }
+    }
+
+    return false;
+  }
+
+  bool operator==(const ColorDegreeSum<kColors> &a) const {
+    for (int i = 0; i < kColors; i++) {
+      if (counts[i] != a.counts[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool operator!=(const ColorDegreeSum<kColors> &a) const {
+    return !(*this == a);
+  }
+
+  // each count is at most a degree, so they are only as wide as a vertex
+  vertex_t counts[kColors];
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_COLORDEGREESUM_H_
@@ -0,0 +1,258 @@
+#ifndef INCLUDE_NISHE_COMPRESSEDGRAPH_H_
+#define INCLUDE_NISHE_COMPRESSEDGRAPH_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Graph.h>
+#include <nishe/MappedFile.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace nishe {
+
+/*
+ * A frozen copy of a graph in compressed sparse row form.
+ *
+ * The nbhds of all of the vertices are stored back to back in one array of
+ * nbhrs (which carry their attrs), and the nbhd of u is the range
+ * [offsets[u], offsets[u + 1]) of it. This avoids one allocation per vertex
+ * and keeps the nbhds that are sown together close in memory.
+ *
+ * The two arrays are either owned by the graph (assign) or are a view of
+ * arrays that live in a mapped file (view), which is how a binary graph file
+ * is used without copying it (see GraphIO::input_binary).
+ *
+ * It provides the same nbhd interface as Graph, so it may be passed to
+ * Refiner, is_automorphism and is_equitable in place of graph_t.
+ */
+template<typename graph_t>
+class CompressedGraph {
+ public:
+  typedef typename graph_t::vertex vertex;
+  typedef typename graph_t::nbhr nbhr;
+  typedef typename graph_t::attr attr;
+  typedef typename graph_t::attr_sum attr_sum;
+
+  // offsets are 64 bits wide everywhere so they match the binary format
+  typedef uint64_t offset;
+
+  CompressedGraph() {
+    clear();
+  }
+
+  explicit CompressedGraph(const graph_t &G) {
+    assign(G);
+  }
+
+  CompressedGraph(const CompressedGraph &G) {
+    *this = G;
+  }
+
+  CompressedGraph &operator=(const CompressedGraph &G) {
+    offsets_ = G.offsets_;
+    nbhrs_ = G.nbhrs_;
+    mapping_ = G.mapping_;
+
+    if (mapping_.is_mapped()) {
+      view_ptrs(G.offsets_ptr_, G.nbhrs_ptr_, G.vertex_count_);
+    } else {
+      own_ptrs();
+    }
+
+    return *this;
+  }
+
+  // replaces this graph with a copy of G
+  void assign(const graph_t &G) {
+    int n = G.vertex_count();
+
+    mapping_.unmap();
+    offsets_.resize(n + 1);
+    offsets_[0] = 0;
+
+    for (int u = 0; u < n; u++) {
+      offsets_[u + 1] = offsets_[u] + G.get_nbhd_size(u);
+    }
+
+    nbhrs_.resize(offsets_[n]);
+
+    for (int u = 0; u < n; u++) {
+      const nbhr *nbhd = G.get_nbhd(u);
+
+      for (size_t i = 0; i < G.get_nbhd_size(u); i++) {
+        nbhrs_[offsets_[u] + i] = nbhd[i];
+      }
+    }
+
+    own_ptrs();
+  }
+
+  /*
+   * Replaces this graph with a copy of G where each vertex u is relabeled
+   * labels[u] (a permutation), with every nbhd sorted by vertex and then
+   * attr. Two graphs relabeled this way are equal exactly when the
+   * relabelings make them identical, which is what a canonical labeling
+   * is checked with (see Canonizer).
+   */
+  void assign_relabeled(const graph_t &G, const int *labels) {
+    int n = G.vertex_count();
+
+    mapping_.unmap();
+    offsets_.resize(n + 1);
+    offsets_[0] = 0;
+
+    for (int u = 0; u < n; u++) {
+      offsets_[labels[u] + 1] = G.get_nbhd_size(u);
+    }
+
+    for (int u = 0; u < n; u++) {
+      offsets_[u + 1] += offsets_[u];
+    }
+
+    nbhrs_.resize(offsets_[n]);
+
+    for (int u = 0; u < n; u++) {
+      const nbhr *nbhd = G.get_nbhd(u);
+      nbhr *relabeled = nbhrs_.empty() ? NULL : &nbhrs_[offsets_[labels[u]]];
+
+      for (int i = 0; i < G.get_nbhd_size(u); i++) {
+        relabeled[i] = make_nbhr(labels[vertex_of(nbhd[i])],
+            attr_of(nbhd[i]));
+      }
+
+      std::sort(relabeled, relabeled + G.get_nbhd_size(u), nbhr_less);
+    }
+
+    own_ptrs();
+  }
+
+  /*
+   * Compares the nbhds of this graph to the ones of b as sequences of
+   * (vertex, attr) (-1, 0 or 1), only equal if the graphs are identical
+   * as they are stored.
+   */
+  int cmp(const CompressedGraph &b) const {
+    if (vertex_count_ != b.vertex_count_) {
+      return vertex_count_ < b.vertex_count_ ? -1 : 1;
+    }
+
+    for (int u = 0; u < vertex_count_; u++) {
+      if (get_nbhd_size(u) != b.get_nbhd_size(u)) {
+        return get_nbhd_size(u) < b.get_nbhd_size(u) ? -1 : 1;
+      }
+    }
+
+    for (size_t i = 0; i < arc_count(); i++) {
+      if (nbhr_less(nbhrs_ptr_[i], b.nbhrs_ptr_[i])) {
+        return -1;
+      } else if (nbhr_less(b.nbhrs_ptr_[i], nbhrs_ptr_[i])) {
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  /*
+   * Replaces this graph with the n vertex graph whose offsets and nbhrs are
+   * already laid out in mapping. Nothing is copied, and this graph keeps
+   * the mapping alive for as long as it views it.
+   */
+  void view(const MappedFile &mapping, const offset *offsets,
+      const nbhr *nbhrs, int n) {
+    offsets_.clear();
+    nbhrs_.clear();
+    mapping_ = mapping;
+
+    view_ptrs(offsets, nbhrs, n);
+  }
+
+  void clear() {
+    offsets_.assign(1, 0);
+    nbhrs_.clear();
+    mapping_.unmap();
+
+    own_ptrs();
+  }
+
+  // whether the nbhds are a view of a mapped file
+  bool is_view() const {
+    return mapping_.is_mapped();
+  }
+
+  const nbhr *get_nbhd(vertex u) const {
+    return nbhrs_ptr_ + offsets_ptr_[u];
+  }
+
+  size_t get_nbhd_size(vertex u) const {
+    return offsets_ptr_[u + 1] - offsets_ptr_[u];
+  }
+
+  int vertex_count() const {
+    return vertex_count_;
+  }
+
+  // the total number of nbhrs over all vertices
+  size_t arc_count() const {
+    return offsets_ptr_[vertex_count_];
+  }
+
+  vertex nbhr_vertex(const nbhr &x) const {
+    return vertex_of(x);
+  }
+
+  attr nbhr_attr(const nbhr &x) const {
+    return attr_of(x);
+  }
+
+  static vertex vertex_of(const nbhr &x) {
+    return graph_t::vertex_of(x);
+  }
+
+  static attr attr_of(const nbhr &x) {
+    return graph_t::attr_of(x);
+  }
+
+  static nbhr make_nbhr(vertex v, attr a) {
+    return graph_t::make_nbhr(v, a);
+  }
+
+ private:
+  static bool nbhr_less(const nbhr &x, const nbhr &y) {
+    if (vertex_of(x) != vertex_of(y)) {
+      return vertex_of(x) < vertex_of(y);
+    }
+
+    return attr_of(x) < attr_of(y);
+  }
+
+  // the nbhd of u is nbhrs_[offsets_[u]] ... nbhrs_[offsets_[u + 1] - 1]
+  std::vector<offset> offsets_;
+  std::vector<nbhr> nbhrs_;
+
+  // the arrays actually used, either the ones above or ones in mapping_
+  const offset *offsets_ptr_;
+  const nbhr *nbhrs_ptr_;
+  int vertex_count_;
+
+  MappedFile mapping_;
+
+  void own_ptrs() {
+    view_ptrs(&offsets_[0], nbhrs_.empty() ? NULL : &nbhrs_[0],
+        offsets_.size() - 1);
+  }
+
+  void view_ptrs(const offset *offsets, const nbhr *nbhrs, int n) {
+    offsets_ptr_ = offsets;
+    nbhrs_ptr_ = nbhrs;
+    vertex_count_ = n;
+  }
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_COMPRESSEDGRAPH_H_
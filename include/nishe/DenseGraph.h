@@ -0,0 +1,71 @@
+#ifndef INCLUDE_NISHE_DENSEGRAPH_H_
+#define INCLUDE_NISHE_DENSEGRAPH_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/BasicGraph.h>
+#include <nishe/CompressedGraph.h>
+#include <nishe/RefinerWorkspace.h>
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace nishe {
+
+/*
+ * A BasicGraph for dense graphs, which along with its nbhds keeps a row of
+ * bits per vertex: bit u of in_row(v) is set when v is a nbhr of u.
+ *
+ * When the refiner sows a cell C, the attr_sum of v is the number of
+ * vertices of C that have v as a nbhr, which is the popcount of
+ * in_row(v) & C. So instead of one increment per nbhr of C this takes
+ * n * row_words() ANDs and popcounts, which is far less work when C has
+ * more nbhrs than that (as in strongly regular and nearly complete graphs).
+ * sow_cell picks whichever way is cheaper for each cell.
+ *
+ * The rows cost n^2 / 8 bytes on top of the nbhds.
+ */
+class DenseGraph: public CompressedGraph<BasicGraph> {
+ public:
+  DenseGraph();
+  explicit DenseGraph(const BasicGraph &G);
+
+  // replaces this graph with a copy of G
+  void assign(const BasicGraph &G);
+
+  void clear();
+
+  // the number of 64 bit words in each row
+  size_t row_words() const {
+    return row_words_;
+  }
+
+  const uint64_t *in_row(vertex v) const {
+    return &in_rows_[v * row_words_];
+  }
+
+  // whether sowing a cell with cell_arc_count nbhrs is cheaper by the rows
+  bool prefers_rows(size_t cell_arc_count) const {
+    return cell_arc_count > vertex_count() * row_words_;
+  }
+
+ private:
+  size_t row_words_;
+  std::vector<uint64_t> in_rows_;
+};
+
+// the number of bits set in both a and b, which are words 64 bit words long
+// (uses AVX2 or POPCNT when the cpu running this has them)
+size_t and_popcount(const uint64_t *a, const uint64_t *b, size_t words);
+
+// the refiner's sow_cell for DenseGraph, see above
+void sow_cell(const DenseGraph &G, const int *cell, int cell_size,
+    RefinerWorkspace<DenseGraph::attr_sum> *workspace_ptr);
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_DENSEGRAPH_H_
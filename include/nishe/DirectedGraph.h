@@ -13,40 +13,82 @@
 namespace nishe {
 
 // a degree triplet (for in, out, and both arcs)
+// defined inline since the refiner sows into these for every arc
+// each count is at most a degree, so they are only as wide as a vertex
 struct InOutBoth {
-  InOutBoth &operator+=(int k);
-  InOutBoth &operator=(int k);
-  bool operator<(const InOutBoth &a) const;
-  bool operator!=(const InOutBoth &a) const;
-  bool operator==(const InOutBoth &a) const;
+  InOutBoth &operator+=(int k) {
+    weights[k] += 1;
 
-  size_t weights[3];
+    return *this;
+  }
+
+  InOutBoth &operator=(int k) {
+    weights[0] = k;
+    weights[1] = k;
+    weights[2] = k;
+
+    return *this;
+  }
+
+  bool operator<(const InOutBoth &a) const {
+    for (size_t i = 0; i < sizeof(weights) / sizeof(*weights); i++) {
+      if (weights[i] < a.weights[i]) {
+        return true;
+      } else if (weights[i] > a.weights[i]) {
+        return false;
+      }
+    }
+
+    return false;
+  }
+
+  bool operator!=(const InOutBoth &a) const {
+    return !(*this == a);
+  }
+
+  bool operator==(const InOutBoth &a) const {
+    for (size_t i = 0; i < sizeof(weights) / sizeof(*weights); i++) {
+      if (weights[i] != a.weights[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  vertex_t weights[3];
 };
 
 /*
  * Represents a directed graph encoded as a weighted graph.
  *
- * The vertex_degree type is a pair of a vertex and a weight of 0, 1, or 2,
+ * The vertex_degree type is a pair of a vertex and a weight of 0, 1, or 2
+ * (the weight is an unsigned int so a nbhr is two words of 32 bit vertices),
  * and the degree sums are triplets of nonnegative integers (in, out, both)
  */
-class DirectedGraph: public Graph<std::pair<vertex_t, size_t>, size_t,
-    InOutBoth> {
+class DirectedGraph: public Graph<DirectedGraph,
+    std::pair<vertex_t, unsigned int>, unsigned int, InOutBoth> {
  public:
-  static const size_t IN;
-  static const size_t OUT;
-  static const size_t BOTH;
+  static const unsigned int IN;
+  static const unsigned int OUT;
+  static const unsigned int BOTH;
 
   // adds the arc (u, v) to the graph
   // returns false if the arc cannot be added (it already exists)
   bool add_arc(vertex_t u, vertex_t v);
 
-  vertex_t nbhr_vertex(const DirectedGraph::nbhr &nbhr) const {
+  // decode a nbhr without needing a graph
+  static vertex_t vertex_of(const DirectedGraph::nbhr &nbhr) {
     return nbhr.first;
   }
 
-  DirectedGraph::attr nbhr_attr(const DirectedGraph::nbhr &nbhr) const {
+  static DirectedGraph::attr attr_of(const DirectedGraph::nbhr &nbhr) {
     return nbhr.second;
   }
+
+  static DirectedGraph::nbhr make_nbhr(vertex_t v, DirectedGraph::attr type) {
+    return std::make_pair(v, type);
+  }
 };
 
 }  // namespace nishe
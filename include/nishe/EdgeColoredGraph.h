@@ -0,0 +1,77 @@
+#ifndef INCLUDE_NISHE_EDGECOLOREDGRAPH_H_
+#define INCLUDE_NISHE_EDGECOLOREDGRAPH_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Graph.h>
+#include <nishe/ColorDegreeSum.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <algorithm>
+
+namespace nishe {
+
+/*
+ * A weighted graph whose weights (colors) are 0 ... kColors - 1.
+ *
+ * The nbhr type is a pair of a vertex and a color, and the degree sums are
+ * ColorDegreeSums, so refining is about as cheap as for a BasicGraph when
+ * kColors is small. GraphIO::convert turns an IntegerWeightedGraph with at
+ * most kColors distinct weights into one of these.
+ */
+template<int kColors>
+class EdgeColoredGraph: public Graph<EdgeColoredGraph<kColors>,
+    std::pair<vertex_t, unsigned int>, unsigned int,
+    ColorDegreeSum<kColors> > {
+ public:
+  typedef Graph<EdgeColoredGraph<kColors>, std::pair<vertex_t, unsigned int>,
+      unsigned int, ColorDegreeSum<kColors> > base;
+
+  static const int COLOR_COUNT = kColors;
+
+  bool add_colored_edge(vertex_t u, vertex_t v, unsigned int color) {
+    return add_colored_arc(u, v, color) && add_colored_arc(v, u, color);
+  }
+
+  // adds the arc (u, v) with the given color
+  // returns false if there is already an arc (u, v)
+  bool add_colored_arc(vertex_t u, vertex_t v, unsigned int color) {
+    if (color >= static_cast<unsigned int>(kColors)) {
+      fprintf(stderr, "Error Error Examine: color %u is not less than %d\n",
+          color, kColors);
+      exit(1);
+    }
+
+    this->add_vertex(std::max(u, v));
+
+    if (this->find_nbhr(u, v) == base::NOT_FOUND) {
+      this->push_nbhr(u, std::make_pair(v, color));
+
+      return true;
+    }
+
+    return false;
+  }
+
+  // decode a nbhr without needing a graph
+  static vertex_t vertex_of(const typename base::nbhr &nbhr) {
+    return nbhr.first;
+  }
+
+  static unsigned int attr_of(const typename base::nbhr &nbhr) {
+    return nbhr.second;
+  }
+
+  static typename base::nbhr make_nbhr(vertex_t v, unsigned int color) {
+    return std::make_pair(v, color);
+  }
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_EDGECOLOREDGRAPH_H_
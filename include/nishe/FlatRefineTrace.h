@@ -0,0 +1,268 @@
+#ifndef INCLUDE_NISHE_FLATREFINETRACE_H_
+#define INCLUDE_NISHE_FLATREFINETRACE_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/ColorDegreeSum.h>
+#include <nishe/DirectedGraph.h>
+#include <nishe/Graph.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace nishe {
+
+/*
+ * How an attr_sum is written into the fixed number of words of a
+ * FlatRefineTrace record, in an order preserving way (comparing the words
+ * lexicographically compares the attr_sums). Only attr_sums of a fixed
+ * size can have one, so there is none for MapDegreeSum.
+ */
+template<typename attr_sum>
+struct AttrSumRecord;
+
+template<>
+struct AttrSumRecord<vertex_t> {
+  static const int WORDS = 1;
+
+  static void write(const vertex_t &attr_sum, vertex_t *words) {
+    words[0] = attr_sum;
+  }
+};
+
+template<>
+struct AttrSumRecord<InOutBoth> {
+  static const int WORDS = 3;
+
+  static void write(const InOutBoth &attr_sum, vertex_t *words) {
+    std::copy(attr_sum.weights, attr_sum.weights + 3, words);
+  }
+};
+
+template<int kColors>
+struct AttrSumRecord<ColorDegreeSum<kColors> > {
+  static const int WORDS = kColors;
+
+  static void write(const ColorDegreeSum<kColors> &attr_sum,
+      vertex_t *words) {
+    std::copy(attr_sum.counts, attr_sum.counts + kColors, words);
+  }
+};
+
+/*
+ * A refine trace laid out as one contiguous buffer of fixed width records,
+ * which the refiner uses in place of a RefineTraceValue
+ * (Refiner<graph_t, FlatRefineTrace<graph_t> >).
+ *
+ * Each record is a word holding an index, followed by the words of an
+ * attr_sum (see AttrSumRecord). The top two bits of the first word say what
+ * was traced: 00 for an active index (stored plus one, as the invariant
+ * step is -1, with attr_sum words of 0), 01 for an (index, invariant) and
+ * 10 for an (index, attr_sum), so an active index record is smaller than
+ * the records traced after it. Comparing the words lexicographically then
+ * orders the traces just as RefineTraceValue::cmp does, including an
+ * active index with fewer attr_sums being smaller. With 32 bit words that
+ * leaves 30 bits for an index.
+ *
+ * Refining against the trace compares each record with memcmp at a cursor,
+ * and cutting the trace off when the refinement is smaller only resets the
+ * length. The buffer is never shrunk, so once it has held the longest
+ * trace (or reserve() was called) recording does not allocate.
+ */
+template<typename graph_t>
+class FlatRefineTrace {
+ public:
+  typedef vertex_t word;
+
+  // the words in one record
+  static const int RECORD_WORDS =
+      1 + AttrSumRecord<typename graph_t::attr_sum>::WORDS;
+
+  FlatRefineTrace() :
+    clear_(true), length_(0), cursor_(0), active_count_(0) {
+  }
+
+  void clear() {
+    length_ = 0;
+    cursor_ = 0;
+    active_count_ = 0;
+    clear_ = true;
+  }
+
+  bool is_clear() {
+    return clear_;
+  }
+
+  void set_clear(bool flag) {
+    clear_ = flag;
+  }
+
+  // makes room for record_count records without growing
+  void reserve(size_t record_count) {
+    if (words_.size() < record_count * RECORD_WORDS) {
+      words_.resize(record_count * RECORD_WORDS);
+    }
+  }
+
+  // the number of active indices traced
+  int size() const {
+    return active_count_;
+  }
+
+  // the number of records (active indices and attr_sums) traced
+  size_t record_count() const {
+    return length_ / RECORD_WORDS;
+  }
+
+  int cmp(const FlatRefineTrace<graph_t> &b) const;
+
+  // see RefineTraceValue
+  void trace_active_index(int k, int active_count, int *cmp_ptr);
+  void trace_attr_sum(int active_count, int adjacent_index,
+      const typename graph_t::attr_sum &attr_sum, int attr_sum_count,
+      int *cmp_ptr);
+  void trace_invariant(int active_count, int index, vertex_t invariant,
+      int invariant_count, int *cmp_ptr);
+
+  void finish_active_index(int active_count, int *cmp_ptr) {
+  }
+
+ private:
+  static const word INVARIANT_FLAG = static_cast<word>(1) << (
+      sizeof(word) * 8 - 2);
+  static const word ATTR_SUM_FLAG = static_cast<word>(2) << (
+      sizeof(word) * 8 - 2);
+
+  // fails unless x fits in the bits below the flags, as one that didn't
+  // would be read as another kind of record
+  static void check_below_flags(int x) {
+    if (x < 0 || static_cast<word>(x) >= INVARIANT_FLAG) {
+      fprintf(stderr,
+          "Error Error Examine: index %d is too large for a trace record\n",
+          x);
+      exit(1);
+    }
+  }
+
+  bool clear_;
+
+  std::vector<word> words_;
+  size_t length_;  // the words in use
+  size_t cursor_;  // where the refinement's next record goes
+  int active_count_;
+
+  // the record being traced
+  word record_[RECORD_WORDS];
+
+  void trace_record(int active_count, int *cmp_ptr);
+};
+
+/*
+ * Compares the words a[0] ... a[a_length - 1] to b[0] ... b[b_length - 1]
+ * lexicographically. Equal prefixes are skipped with memcmp.
+ */
+template<typename word>
+int compare_words(const word *a, size_t a_length, const word *b,
+    size_t b_length) {
+  size_t length = std::min(a_length, b_length);
+
+  if (length > 0 && memcmp(a, b, length * sizeof(word)) != 0) {
+    std::pair<const word *, const word *> diff = std::mismatch(a, a + length,
+        b);
+    return *diff.first < *diff.second ? -1 : 1;
+  }
+
+  if (a_length != b_length) {
+    return a_length < b_length ? -1 : 1;
+  }
+
+  return 0;
+}
+
+template<typename graph_t>
+int FlatRefineTrace<graph_t>::cmp(const FlatRefineTrace<graph_t> &b) const {
+  return compare_words(words_.empty() ? NULL : &words_[0], length_,
+      b.words_.empty() ? NULL : &b.words_[0], b.length_);
+}
+
+template<typename graph_t>
+void FlatRefineTrace<graph_t>::trace_active_index(int k, int active_count,
+    int *cmp_ptr) {
+  // a refinement starts over at the front
+  if (active_count == 0) {
+    cursor_ = 0;
+  }
+
+  check_below_flags(k + 1);
+  record_[0] = k + 1;
+  std::fill(record_ + 1, record_ + RECORD_WORDS, 0);
+
+  trace_record(active_count, cmp_ptr);
+}
+
+template<typename graph_t>
+void FlatRefineTrace<graph_t>::trace_attr_sum(int active_count,
+    int adjacent_index, const typename graph_t::attr_sum &attr_sum,
+    int attr_sum_count, int *cmp_ptr) {
+  check_below_flags(adjacent_index);
+  record_[0] = ATTR_SUM_FLAG | adjacent_index;
+  AttrSumRecord<typename graph_t::attr_sum>::write(attr_sum, record_ + 1);
+
+  trace_record(active_count, cmp_ptr);
+}
+
+template<typename graph_t>
+void FlatRefineTrace<graph_t>::trace_invariant(int active_count, int index,
+    vertex_t invariant, int invariant_count, int *cmp_ptr) {
+  check_below_flags(index);
+  record_[0] = INVARIANT_FLAG | index;
+  record_[1] = invariant;
+  std::fill(record_ + 2, record_ + RECORD_WORDS, 0);
+
+  trace_record(active_count, cmp_ptr);
+}
+
+/*
+ * Compares record_ to the record at the cursor, cutting the trace off
+ * there if record_ is smaller, and appends it if the trace is being
+ * recorded.
+ */
+template<typename graph_t>
+void FlatRefineTrace<graph_t>::trace_record(int active_count, int *cmp_ptr) {
+  assert(*cmp_ptr != 1);
+
+  if (*cmp_ptr == 0) {
+    // running out of trace makes the refinement's trace larger
+    int diff = cursor_ < length_ ? compare_words(record_, RECORD_WORDS,
+        &words_[cursor_], RECORD_WORDS) : 1;
+
+    if (diff == 1) {
+      *cmp_ptr = 1;
+      return;
+    } else if (diff == -1) {
+      *cmp_ptr = -1;
+    }
+  }
+
+  if (*cmp_ptr == -1) {
+    length_ = cursor_;
+    reserve(length_ / RECORD_WORDS + 1);
+
+    std::copy(record_, record_ + RECORD_WORDS, words_.begin() + length_);
+    length_ += RECORD_WORDS;
+    active_count_ = active_count + 1;
+  }
+
+  cursor_ += RECORD_WORDS;
+}
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_FLATREFINETRACE_H_
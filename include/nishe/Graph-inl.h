@@ -26,22 +26,22 @@ bool is_automorphism(const graph_t &G, const int *x) {
       return false;
     }
 
-    map<vertex_t, typename graph_t::attr> nbhd_image;
+    map<typename graph_t::vertex, typename graph_t::attr> nbhd_image;
     const typename graph_t::nbhr *nbhd = G.get_nbhd(u);
 
     // collect v_x, degree for v in u's nbhd
     for (int i = 0; i < G.get_nbhd_size(u); i++) {
-      vertex_t v = G.nbhr_vertex(nbhd[i]);
-      vertex_t v_x = x[v];
+      typename graph_t::vertex v = graph_t::vertex_of(nbhd[i]);
+      typename graph_t::vertex v_x = x[v];
 
-      nbhd_image[v_x] = G.nbhr_attr(nbhd[i]);
+      nbhd_image[v_x] = graph_t::attr_of(nbhd[i]);
     }
 
     nbhd = G.get_nbhd(u_x);
 
     // verify that u_x's nbhd is nbhd_image
     for (int i = 0; i < G.get_nbhd_size(u_x); i++) {
-      vertex_t v = G.nbhr_vertex(nbhd[i]);
+      typename graph_t::vertex v = graph_t::vertex_of(nbhd[i]);
 
       // if v isn't found
       if (nbhd_image.find(v) == nbhd_image.end()) {
@@ -49,7 +49,7 @@ bool is_automorphism(const graph_t &G, const int *x) {
       }
 
       // verify that v's degree is equal to the images
-      if (nbhd_image[v] != G.nbhr_attr(nbhd[i])) {
+      if (nbhd_image[v] != graph_t::attr_of(nbhd[i])) {
         return false;
       }
     }
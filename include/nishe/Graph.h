@@ -6,40 +6,90 @@
   Released under the Lesser General Public License v3.
 */
 
+#include <nishe/ArcIndex.h>
+
+#include <stdint.h>
+
 #include <vector>
 #include <utility>
 #include <map>
 
-// a vertex is any nonnegatve integer
+/*
+ * A vertex is any nonnegatve integer.
+ *
+ * Vertices are 32 bits wide unless NISHE_VERTEX_BITS is defined to be 64,
+ * which halves the size of a nbhd compared to size_t. The elements of a
+ * PartitionNest are ints, so no graph can use more than 2^31 vertices anyway.
+ *
+ * This is a compile time switch for the whole library, not a template
+ * parameter: code using nishe has to be compiled with the same
+ * NISHE_VERTEX_BITS as the library it links, which is built by scons with
+ * vertex_bits=64 (as libnishe<config>-64, so the two can't be confused).
+ */
+#if defined(NISHE_VERTEX_BITS) && NISHE_VERTEX_BITS == 64
 typedef size_t vertex_t;
+#else
+typedef uint32_t vertex_t;
+#endif
 
 namespace nishe {
 
+class GraphBuilder;
+
 template<typename graph_t>
 bool is_automorphism(const graph_t &G, const int *x);
 
 /*
  * The graph class must provide the ability to iterate over the neighbors
  * of a vertex.
+ *
+ * graph_t is the derived graph type, which must provide the static functions
+ *   vertex_type vertex_of(const nbhr_t &)
+ *   attr_t attr_of(const nbhr_t &)
+ * to decode a nbhr, and
+ *   nbhr_t make_nbhr(vertex_type, attr_t)
+ * to encode one (used to relabel a graph). Code that is templated on the graph type (like Refiner)
+ * calls these directly, so decoding a nbhr inlines in the hot loops.
+ *
+ * vertex_type is the integer type of a vertex (and so the width of the
+ * vertices stored in the nbhds), vertex_t unless a graph type says otherwise.
+ *
+ * nbhr_vertex/nbhr_attr are the polymorphic interface to the same thing.
+ * They are virtual unless NISHE_NO_VIRTUAL_GRAPH is defined, in which case
+ * graphs have no vtable at all. Like NISHE_VERTEX_BITS that changes every
+ * graph type, so code defining it has to link the library scons builds
+ * with virtual_graph=no (libnishe<config>-nv).
  */
-template<typename nbhr_t, typename attr_t, typename attr_sum_t>
+#ifdef NISHE_NO_VIRTUAL_GRAPH
+#define NISHE_GRAPH_VIRTUAL
+#else
+#define NISHE_GRAPH_VIRTUAL virtual
+#endif
+
+template<typename graph_t, typename nbhr_t, typename attr_t,
+    typename attr_sum_t, typename vertex_type = vertex_t>
 class Graph {
  public:
 
-  virtual ~Graph() {
+  Graph() :
+    indexed_(false) {
   }
 
+  NISHE_GRAPH_VIRTUAL ~Graph() {
+  }
+
+  typedef vertex_type vertex;
   typedef nbhr_t nbhr;
   typedef attr_t attr;
   typedef attr_sum_t attr_sum;
   static const int NOT_FOUND;
 
-  const nbhr_t *get_nbhd(vertex_t u) const {
-    return &vNbhds.at(u).front();
+  const nbhr_t *get_nbhd(vertex_type u) const {
+    return &vNbhds[u].front();
   }
 
-  size_t get_nbhd_size(vertex_t u) const {
-    return vNbhds.at(u).size();
+  size_t get_nbhd_size(vertex_type u) const {
+    return vNbhds[u].size();
   }
 
   int vertex_count() const {
@@ -48,23 +98,33 @@ class Graph {
 
   void clear() {
     vNbhds.clear();
+    arc_index_.clear();
+  }
+
+  NISHE_GRAPH_VIRTUAL vertex_type nbhr_vertex(const nbhr_t &nbhr) const {
+    return graph_t::vertex_of(nbhr);
   }
 
-  virtual vertex_t nbhr_vertex(const nbhr_t &nbhr) const = 0;
-  virtual attr_t nbhr_attr(const nbhr_t &nbhr) const = 0;
+  NISHE_GRAPH_VIRTUAL attr_t nbhr_attr(const nbhr_t &nbhr) const {
+    return graph_t::attr_of(nbhr);
+  }
 
   // increases the number of vertices to u if needed
   // (also adds all vertices less than u)
-  void add_vertex(vertex_t u) {
+  void add_vertex(vertex_type u) {
     if (vNbhds.size() < u + 1) {
       vNbhds.resize(u + 1);
     }
   }
 
   // search for v in the nbhd of u
-  int find_nbhr(vertex_t u, vertex_t v) {
+  int find_nbhr(vertex_type u, vertex_type v) {
+    if (indexed_) {
+      return arc_index_.find(u, v);
+    }
+
     for (int i = 0; i < vNbhds.at(u).size(); i++) {
-      if (nbhr_vertex(vNbhds.at(u).at(i)) == v) {
+      if (graph_t::vertex_of(vNbhds.at(u).at(i)) == v) {
         return i;
       }
     }
@@ -72,12 +132,76 @@ class Graph {
     return NOT_FOUND;
   }
 
+  /*
+   * While a graph is indexed, every arc is also kept in a hash table so that
+   * find_nbhr (and so adding an arc) is O(1) instead of a scan of u's nbhd.
+   * Meant to be turned on while building a graph and off once it's built,
+   * since the index costs more memory than the nbhds themselves.
+   */
+  void set_indexed(bool indexed) {
+    if (indexed == indexed_) {
+      return;
+    }
+
+    indexed_ = indexed;
+    reindex();
+  }
+
+  bool is_indexed() const {
+    return indexed_;
+  }
+
  protected:
   std::vector<std::vector<nbhr_t> > vNbhds;
+
+  // fills in vNbhds directly when building from a list of arcs
+  friend class GraphBuilder;
+
+  // rebuilds the arc index (if indexed) from vNbhds, after they were
+  // written directly
+  void reindex() {
+    arc_index_.clear();
+
+    if (!indexed_) {
+      return;
+    }
+
+    size_t arc_count = 0;
+
+    for (vertex_type u = 0; u < vNbhds.size(); u++) {
+      arc_count += vNbhds[u].size();
+    }
+
+    arc_index_.reserve(arc_count);
+
+    for (vertex_type u = 0; u < vNbhds.size(); u++) {
+      // insert backwards so the first of any repeated nbhr is the one found
+      for (int i = vNbhds[u].size() - 1; i >= 0; i--) {
+        arc_index_.insert(u, graph_t::vertex_of(vNbhds[u][i]), i);
+      }
+    }
+  }
+
+  // appends x to u's nbhd, keeping the arc index up to date
+  void push_nbhr(vertex_type u, const nbhr_t &x) {
+    vertex_type v = graph_t::vertex_of(x);
+
+    if (indexed_ && arc_index_.find(u, v) == NOT_FOUND) {
+      arc_index_.insert(u, v, vNbhds.at(u).size());
+    }
+
+    vNbhds.at(u).push_back(x);
+  }
+
+ private:
+  bool indexed_;
+  ArcIndex arc_index_;
 };
 
-template<typename nbhr_t, typename attr_t, typename attr_sum_t>
-const int Graph<nbhr_t, attr_t, attr_sum_t>::NOT_FOUND = -1;
+template<typename graph_t, typename nbhr_t, typename attr_t,
+    typename attr_sum_t, typename vertex_type>
+const int Graph<graph_t, nbhr_t, attr_t, attr_sum_t, vertex_type>::NOT_FOUND =
+    -1;
 
 }  // namespace nishe
 
@@ -0,0 +1,100 @@
+#ifndef INCLUDE_NISHE_GRAPHBUILDER_H_
+#define INCLUDE_NISHE_GRAPHBUILDER_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Graphs.h>
+
+#include <vector>
+
+using std::vector;
+
+namespace nishe {
+
+/*
+ * Builds graphs from whole lists of arcs at once.
+ *
+ * Arcs are only collected by the add methods. finalize() radix sorts them
+ * by (u, v) (with thread_count threads for large lists), drops repeated arcs
+ * keeping the first one added, and writes the nbhds of the graph directly,
+ * so no arc ever goes through find_nbhr. An indexed graph has its index
+ * rebuilt once at the end.
+ *
+ * The resulting graph has the same arcs it would have had if they were
+ * added one at a time with add_arc/add_weighted_arc, including an arc and
+ * its reverse becoming BOTH in a DirectedGraph; only the order within each
+ * nbhd may differ. add_edges is the same as adding (u, v) and then (v, u)
+ * as arcs, edge by edge.
+ *
+ * The builder is empty after finalize() but keeps its memory, so one builder
+ * can be reused for many graphs without reallocating.
+ */
+class GraphBuilder {
+ public:
+  // sorts with thread_count threads, or one in a build without threads
+  explicit GraphBuilder(int thread_count = 1);
+
+  void add_arcs(const vertex_t *us, const vertex_t *vs, size_t count);
+  void add_edges(const vertex_t *us, const vertex_t *vs, size_t count);
+
+  void add_weighted_arcs(const vertex_t *us, const vertex_t *vs,
+      const int *weights, size_t count);
+  void add_weighted_edges(const vertex_t *us, const vertex_t *vs,
+      const int *weights, size_t count);
+
+  // increases the number of vertices to u + 1 if needed (like Graph's)
+  void add_vertex(vertex_t u);
+
+  // replace *G_ptr with the graph of the arcs added so far
+  void finalize(BasicGraph *G_ptr);
+  void finalize(DirectedGraph *G_ptr);
+  void finalize(IntegerWeightedGraph *G_ptr);
+  void finalize(PackedDirectedGraph *G_ptr);
+
+  // forgets every arc and vertex (but keeps the memory)
+  void clear();
+
+  size_t arc_count() const;
+  int vertex_count() const;
+
+  // an arc with both ends packed into one key so it sorts as (u, v)
+  struct KeyedArc {
+    unsigned long long key;
+    int weight;
+  };
+
+ private:
+  int thread_count_;
+  size_t vertex_count_;
+
+  vector<vertex_t> us_;
+  vector<vertex_t> vs_;
+  vector<int> weights_;
+
+  // scratch space for the sort, kept between graphs
+  vector<KeyedArc> arcs_;
+  vector<KeyedArc> arcs_temp_;
+
+  int vertex_bits_;
+
+  void add(const vertex_t *us, const vertex_t *vs, const int *weights,
+      size_t count, bool reverse);
+
+  // finalize for DirectedGraph and PackedDirectedGraph
+  template<typename graph_t>
+  void finalize_directed(graph_t *G_ptr);
+
+  // sorts and dedups the arcs into arcs_, returns the vertex count
+  int sort_arcs();
+
+  vertex_t key_u(unsigned long long key) const;
+  vertex_t key_v(unsigned long long key) const;
+  unsigned long long make_key(vertex_t u, vertex_t v) const;
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_GRAPHBUILDER_H_
@@ -10,6 +10,8 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 
 using std::stringstream;
 
@@ -45,7 +47,7 @@ bool GraphIO::input_list_ascii(string s, graph_t *pG, PartitionNest *pPi) {
 
 template<typename graph_t>
 bool GraphIO::input_list_ascii(istream &in, graph_t *pG, PartitionNest *pPi,
-    bool (*add_nbhr)(graph_t *, vertex_t, string)) {
+    bool (*add_nbhr)(graph_t *, typename graph_t::vertex, string)) {
   string line;
   string token;
   string partition;  // stores the line containing the partition
@@ -61,10 +63,14 @@ bool GraphIO::input_list_ascii(istream &in, graph_t *pG, PartitionNest *pPi,
     return false;
   }
 
+  // index the arcs while reading so repeated arcs are found in O(1)
+  bool was_indexed = pG->is_indexed();
+  pG->set_indexed(true);
+
   while (!is_whitespace(line)) {
     stringstream ss(line);
 
-    vertex_t u = 0;
+    typename graph_t::vertex u = 0;
     ss >> u;
 
     if (ss.fail()) {  // don't need to check if negative
@@ -131,6 +137,8 @@ bool GraphIO::input_list_ascii(istream &in, graph_t *pG, PartitionNest *pPi,
      }*/
   }
 
+  pG->set_indexed(was_indexed);
+
   if (partition.size() == 0) {
     pPi->unit(pG->vertex_count());
   } else {  // we must have a partition on our hands
@@ -153,9 +161,7 @@ bool GraphIO::input_list_ascii(istream &in, graph_t *pG, PartitionNest *pPi,
 template<typename graph_t, typename nbhr_t>
 void GraphIO::output_list_ascii(ostream &out, const graph_t &G,
     void(*output_nbhr)(ostream &out, const nbhr_t &nbhr)) {
-  vertex_t u = 0;
-
-  for (vertex_t u = 0; u < G.vertex_count(); u++) {
+  for (typename graph_t::vertex u = 0; u < G.vertex_count(); u++) {
     out << u << " : ";
 
     for (int i = 0; i < G.get_nbhd_size(u); i++) {
@@ -177,25 +183,155 @@ void GraphIO::output_list_ascii(ostream &out, const graph_t &G,
 
 template <typename graph_a, typename graph_b, typename graph_a_attr>
 void GraphIO::convert(const graph_a &G1, graph_b *G2_ptr,
-    void (*grapha2graphb)(vertex_t u, vertex_t v,
-        const graph_a_attr &attr, graph_b *G_ptr) )
+    void (*grapha2graphb)(typename graph_a::vertex u,
+        typename graph_a::vertex v, const graph_a_attr &attr, graph_b *G_ptr) )
 {
   // clear the output graph and make it have the same vertices
   G2_ptr->clear();
   G2_ptr->add_vertex(G1.vertex_count() - 1);
 
+  bool was_indexed = G2_ptr->is_indexed();
+  G2_ptr->set_indexed(true);
+
   for (int u = 0; u < G1.vertex_count(); u++)
   {
     const typename graph_a::nbhr *nbhd = G1.get_nbhd(u);
 
     for (int i = 0; i < G1.get_nbhd_size(u); i++)
     {
-      vertex_t v = G1.nbhr_vertex(nbhd[i]);
+      typename graph_a::vertex v = G1.nbhr_vertex(nbhd[i]);
 
       // call the conversion function to add the arc
       grapha2graphb(u, v, G1.nbhr_attr(nbhd[i]), G2_ptr);
     }
   }
+
+  G2_ptr->set_indexed(was_indexed);
+}
+
+template<int kColors>
+void GraphIO::convert(const IntegerWeightedGraph &weighted,
+    EdgeColoredGraph<kColors> *colored_ptr) {
+  vector<int> weights;
+
+  for (int u = 0; u < weighted.vertex_count(); u++) {
+    const IntegerWeightedGraph::nbhr *nbhd = weighted.get_nbhd(u);
+
+    for (int i = 0; i < weighted.get_nbhd_size(u); i++) {
+      weights.push_back(IntegerWeightedGraph::attr_of(nbhd[i]));
+    }
+  }
+
+  // the color of a weight is its position among the distinct weights
+  std::sort(weights.begin(), weights.end());
+  weights.erase(std::unique(weights.begin(), weights.end()), weights.end());
+
+  if (weights.size() > kColors) {
+    stringstream ss;
+    ss << "graph has " << weights.size() << " distinct weights but only ";
+    ss << kColors << " colors";
+    fail(ss.str());
+  }
+
+  colored_ptr->clear();
+
+  if (weighted.vertex_count() > 0) {
+    colored_ptr->add_vertex(weighted.vertex_count() - 1);
+  }
+
+  bool was_indexed = colored_ptr->is_indexed();
+  colored_ptr->set_indexed(true);
+
+  for (int u = 0; u < weighted.vertex_count(); u++) {
+    const IntegerWeightedGraph::nbhr *nbhd = weighted.get_nbhd(u);
+
+    for (int i = 0; i < weighted.get_nbhd_size(u); i++) {
+      int weight = IntegerWeightedGraph::attr_of(nbhd[i]);
+      unsigned int color = std::lower_bound(weights.begin(), weights.end(),
+          weight) - weights.begin();
+
+      colored_ptr->add_colored_arc(u, IntegerWeightedGraph::vertex_of(nbhd[i]),
+          color);
+    }
+  }
+
+  colored_ptr->set_indexed(was_indexed);
+}
+
+template<typename graph_t>
+void GraphIO::output_binary(ostream &out, const graph_t &G,
+    const PartitionNest *pi_ptr) {
+  typedef typename graph_t::nbhr nbhr;
+
+  int n = G.vertex_count();
+  vector<uint64_t> offsets(n + 1);
+
+  for (int u = 0; u < n; u++) {
+    offsets[u + 1] = offsets[u] + G.get_nbhd_size(u);
+  }
+
+  output_binary_header(out, binary_type(&G), sizeof(nbhr), n, offsets[n],
+      pi_ptr);
+
+  out.write(reinterpret_cast<const char *>(&offsets[0]),
+      offsets.size() * sizeof(uint64_t));
+
+  for (int u = 0; u < n; u++) {
+    out.write(reinterpret_cast<const char *>(G.get_nbhd(u)),
+        G.get_nbhd_size(u) * sizeof(nbhr));
+  }
+
+  // pad the nbhrs so the partition is aligned
+  size_t padding = (8 - offsets[n] * sizeof(nbhr) % 8) % 8;
+
+  for (size_t i = 0; i < padding; i++) {
+    out.put(0);
+  }
+
+  if (pi_ptr != NULL) {
+    output_binary_partition(out, *pi_ptr);
+  }
+}
+
+template<typename graph_t>
+bool GraphIO::input_binary(string path, CompressedGraph<graph_t> *G_ptr,
+    PartitionNest *pi_ptr) {
+  typedef typename graph_t::nbhr nbhr;
+
+  MappedFile mapping;
+
+  if (!mapping.map(path)) {
+    return false;
+  }
+
+  const BinaryHeader *header = check_binary(mapping,
+      binary_type(static_cast<const graph_t *>(NULL)), sizeof(nbhr));
+
+  const char *data = mapping.data();
+  const nbhr *nbhrs =
+      reinterpret_cast<const nbhr *>(data + binary_nbhrs_start(*header));
+
+  // a nbhr that isn't a vertex, or whose attr isn't one the graph type has,
+  // would be used to index past the graph or its degree sums
+  for (uint64_t i = 0; i < header->arc_count; i++) {
+    if (static_cast<uint64_t>(graph_t::vertex_of(nbhrs[i]))
+        >= header->vertex_count) {
+      fail("binary graph file has a nbhr that is not a vertex");
+    }
+
+    if (!is_valid_attr(static_cast<const graph_t *>(NULL),
+        graph_t::attr_of(nbhrs[i]))) {
+      fail("binary graph file has a nbhr with an invalid attr");
+    }
+  }
+
+  G_ptr->view(mapping,
+      reinterpret_cast<const uint64_t *>(data + sizeof(BinaryHeader)), nbhrs,
+      header->vertex_count);
+
+  input_binary_partition(mapping, pi_ptr);
+
+  return true;
 }
 
 template<typename graph_t>
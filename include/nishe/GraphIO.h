@@ -49,10 +49,42 @@ namespace nishe {
  *
  *         n v c means vertex v has color c, where c is an unsigned int
  *         e u v means there's an edge from u to v
+ *         c ... is a comment line
+ *
+ *         vertices without an n line have color 0, and pi has one cell per
+ *         color in increasing order of color
+ *
+ * 4) binary (0-based, native byte order, meant to be mapped and not parsed)
+ *         header          BinaryHeader
+ *         offsets         uint64_t[vertex_count + 1]
+ *         nbhrs           graph_t::nbhr[arc_count], padded to 8 bytes
+ *         <pi> elements   int32_t[vertex_count]
+ *         <pi> indices    int32_t[index_count] (the cells after the first)
+ *
+ *         the nbhd of u is nbhrs[offsets[u]] ... nbhrs[offsets[u + 1] - 1],
+ *         exactly the arrays of a CompressedGraph, so a mapped file is used
+ *         as the graph in place. the attrs are the ones stored in the nbhrs
+ *         (the arc types of a PackedDirectedGraph, the weights of an
+ *         IntegerWeightedGraph, ...) and the partition is only present when
+ *         the header has BINARY_HAS_PARTITION set.
  */
 
 void fail(string err);
 
+// the header of a binary graph file, 56 bytes
+struct BinaryHeader {
+  uint64_t magic;  // BINARY_MAGIC, which also catches the wrong byte order
+  uint32_t version;
+  uint32_t graph_type;  // which graph type wrote the nbhrs
+  uint32_t vertex_bytes;  // sizeof(vertex_t) of the writer
+  uint32_t nbhr_bytes;
+  uint64_t vertex_count;
+  uint64_t arc_count;
+  uint64_t index_count;  // the number of partition indices stored
+  uint32_t flags;
+  uint32_t reserved;
+};
+
 class GraphIO {
  public:
 
@@ -67,9 +99,24 @@ class GraphIO {
   static bool input_list_ascii(istream &in, IntegerWeightedGraph *G_ptr,
       PartitionNest *pi_ptr);
 
+  static bool input_list_ascii(istream &in, PackedDirectedGraph *G_ptr,
+      PartitionNest *pi_ptr);
+
   template<typename graph_t>
   static bool input_list_ascii(string s, graph_t *G_ptr, PartitionNest *pi_ptr);
 
+  // the colors become *pi_ptr directly (see PartitionNest::colored)
+  // for directed graphs e u v is the arc (u, v)
+  // returns false if there is no graph to read, fails if it is malformed
+  static bool input_dimacs(istream &in, BasicGraph *G_ptr,
+      PartitionNest *pi_ptr);
+
+  static bool input_dimacs(istream &in, DirectedGraph *G_ptr,
+      PartitionNest *pi_ptr);
+
+  static bool input_dimacs(istream &in, PackedDirectedGraph *G_ptr,
+      PartitionNest *pi_ptr);
+
   // output methods
 
   static void output_list_ascii(ostream &out, const BasicGraph &G);
@@ -78,9 +125,26 @@ class GraphIO {
 
   static void output_list_ascii(ostream &out, const IntegerWeightedGraph &G);
 
+  static void output_list_ascii(ostream &out, const PackedDirectedGraph &G);
+
   template<typename graph_t>
   static string output_list_ascii_string(const graph_t &G);
 
+  // binary files
+
+  // writes G (any graph type or a CompressedGraph of one) and the partition
+  // *pi_ptr if it is not NULL
+  template<typename graph_t>
+  static void output_binary(ostream &out, const graph_t &G,
+      const PartitionNest *pi_ptr = NULL);
+
+  // maps the file at path and makes *G_ptr a view of it without copying
+  // any nbhds, *pi_ptr is the stored partition (or the unit partition)
+  // returns false if the file cannot be mapped, fails if it is malformed
+  template<typename graph_t>
+  static bool input_binary(string path, CompressedGraph<graph_t> *G_ptr,
+      PartitionNest *pi_ptr);
+
   // conversions
 
   // conversions
@@ -95,6 +159,20 @@ class GraphIO {
   static void convert(const DirectedGraph &directed,
       IntegerWeightedGraph *integer_weighted_ptr);
 
+  // the same arcs, with the nbhrs packed or unpacked
+  static void convert(const DirectedGraph &directed,
+      PackedDirectedGraph *packed_ptr);
+
+  static void convert(const PackedDirectedGraph &packed,
+      DirectedGraph *directed_ptr);
+
+  // maps the distinct weights to the colors 0, 1, ... in increasing order
+  // (so colors compare the same way their weights did)
+  // fails if there are more than kColors distinct weights
+  template<int kColors>
+  static void convert(const IntegerWeightedGraph &weighted,
+      EdgeColoredGraph<kColors> *colored_ptr);
+
   // named graphs
   static void path(BasicGraph *G_ptr, int n);
   static void path(BasicGraph *G_ptr, PartitionNest *pi_ptr, int n);
@@ -109,11 +187,53 @@ class GraphIO {
   static void null(graph_t *G_ptr, PartitionNest *pi_ptr, int n);
 
  private:
+  static const uint64_t BINARY_MAGIC;
+  static const uint32_t BINARY_VERSION;
+  static const uint32_t BINARY_HAS_PARTITION;
+
+  // the graph_type stored in a binary file for each graph type
+  static uint32_t binary_type(const BasicGraph *);
+  static uint32_t binary_type(const DirectedGraph *);
+  static uint32_t binary_type(const IntegerWeightedGraph *);
+  static uint32_t binary_type(const PackedDirectedGraph *);
+
+  template<typename graph_t>
+  static uint32_t binary_type(const CompressedGraph<graph_t> *) {
+    return binary_type(static_cast<const graph_t *>(NULL));
+  }
+
+  // whether an attr read from a binary file is one a graph_t nbhr can have
+  static bool is_valid_attr(const BasicGraph *, BasicGraph::attr attr);
+  static bool is_valid_attr(const DirectedGraph *, DirectedGraph::attr attr);
+  static bool is_valid_attr(const IntegerWeightedGraph *,
+      IntegerWeightedGraph::attr attr);
+  static bool is_valid_attr(const PackedDirectedGraph *,
+      PackedDirectedGraph::attr attr);
+
+  static void output_binary_header(ostream &out, uint32_t graph_type,
+      uint32_t nbhr_bytes, int vertex_count, uint64_t arc_count,
+      const PartitionNest *pi_ptr);
+
+  static void output_binary_partition(ostream &out, const PartitionNest &pi);
+
+  // fails unless mapping holds a whole binary graph written as graph_type,
+  // returns its header
+  static const BinaryHeader *check_binary(const MappedFile &mapping,
+      uint32_t graph_type, uint32_t nbhr_bytes);
+
+  // where each section of a binary file starts
+  static size_t binary_nbhrs_start(const BinaryHeader &header);
+  static size_t binary_partition_start(const BinaryHeader &header);
+
+  static void input_binary_partition(const MappedFile &mapping,
+      PartitionNest *pi_ptr);
+
   // returns false if cannot read any of the graph (eof)
   // fails if graph is input improperly
   template<typename graph_t>
   static bool input_list_ascii(istream &in, graph_t *G_ptr,
-      PartitionNest *pi_ptr, bool (*add_nbhr)(graph_t *, vertex_t, string));
+      PartitionNest *pi_ptr,
+      bool (*add_nbhr)(graph_t *, typename graph_t::vertex, string));
 
   template<typename graph_t, typename nbhr_t>
   static void output_list_ascii(ostream &out, const graph_t &G,
@@ -121,7 +241,8 @@ class GraphIO {
 
   template <typename graph_a, typename graph_b, typename graph_a_attr>
   static void convert(const graph_a &G1, graph_b *G2_ptr,
-      void (*grapha2graphb)(vertex_t u, vertex_t v,
+      void (*grapha2graphb)(typename graph_a::vertex u,
+          typename graph_a::vertex v,
           const graph_a_attr &attr, graph_b *G_ptr));
 };
 
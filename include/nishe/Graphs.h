@@ -10,6 +10,10 @@
 #include <nishe/BasicGraph.h>
 #include <nishe/DirectedGraph.h>
 #include <nishe/IntegerWeightedGraph.h>
+#include <nishe/PackedDirectedGraph.h>
+#include <nishe/DenseGraph.h>
+#include <nishe/EdgeColoredGraph.h>
+#include <nishe/CompressedGraph.h>
 
 #include <map>
 #include <utility>
@@ -13,20 +13,26 @@
 
 namespace nishe {
 
-class IntegerWeightedGraph: public Graph<std::pair<vertex_t, int>, int,
-    MapDegreeSum<int> > {
+class IntegerWeightedGraph: public Graph<IntegerWeightedGraph,
+    std::pair<vertex_t, int>, int, MapDegreeSum<int> > {
  public:
   bool add_weighted_edge(vertex_t u, vertex_t v, int weight);
   bool add_weighted_arc(vertex_t u, vertex_t v, int weight);
 
-  vertex_t nbhr_vertex(const IntegerWeightedGraph::nbhr &nbhr) const {
+  // decode a nbhr without needing a graph
+  static vertex_t vertex_of(const IntegerWeightedGraph::nbhr &nbhr) {
     return nbhr.first;
   }
 
-  IntegerWeightedGraph::attr nbhr_attr(
-      const IntegerWeightedGraph::nbhr &nbhr) const {
+  static IntegerWeightedGraph::attr attr_of(
+      const IntegerWeightedGraph::nbhr &nbhr) {
     return nbhr.second;
   }
+
+  static IntegerWeightedGraph::nbhr make_nbhr(vertex_t v,
+      IntegerWeightedGraph::attr weight) {
+    return std::make_pair(v, weight);
+  }
 };
 
 }  // namespace nishe
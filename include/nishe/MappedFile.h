@@ -0,0 +1,53 @@
+#ifndef INCLUDE_NISHE_MAPPEDFILE_H_
+#define INCLUDE_NISHE_MAPPEDFILE_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <cstddef>
+#include <string>
+
+namespace nishe {
+
+/*
+ * A whole file mapped read only into memory (with mmap, or with
+ * MapViewOfFile on Windows).
+ *
+ * Copies share the same mapping, which is unmapped when the last copy goes
+ * away, so a graph viewing the mapped bytes can simply keep a copy of this.
+ * The sharing is not thread safe: copy and destroy copies from one thread.
+ */
+class MappedFile {
+ public:
+  MappedFile();
+  MappedFile(const MappedFile &f);
+  ~MappedFile();
+
+  MappedFile &operator=(const MappedFile &f);
+
+  // maps the file at path, returns false if it can't be opened or is empty
+  bool map(std::string path);
+
+  // drops this copy's reference to the mapping
+  void unmap();
+
+  bool is_mapped() const;
+
+  const char *data() const;
+  size_t size() const;
+
+ private:
+  struct Mapping {
+    void *addr;
+    size_t size;
+    int refs;
+  };
+
+  Mapping *mapping_;
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_MAPPEDFILE_H_
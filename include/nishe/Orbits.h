@@ -0,0 +1,105 @@
+#ifndef INCLUDE_NISHE_ORBITS_H_
+#define INCLUDE_NISHE_ORBITS_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <vector>
+#include <algorithm>
+
+namespace nishe {
+
+/*
+ * The orbits of the vertices 0 ... n - 1 under a group that grows one
+ * permutation at a time, as a union-find. The root of an orbit is always
+ * its smallest vertex, so find() is the orbit's canonical representative.
+ *
+ * An orbit can also be marked (the search marks the orbits of the children
+ * it has been through), and merging a marked orbit keeps the mark.
+ */
+class Orbits {
+ public:
+  Orbits() :
+    orbit_count_(0) {
+  }
+
+  // every vertex in an orbit of its own, and none marked
+  void reset(int n) {
+    parents_.resize(n);
+
+    for (int u = 0; u < n; u++) {
+      parents_[u] = u;
+    }
+
+    marked_.assign(n, false);
+    orbit_count_ = n;
+  }
+
+  int size() const {
+    return parents_.size();
+  }
+
+  // the smallest vertex in u's orbit
+  int find(int u) {
+    while (parents_[u] != u) {
+      parents_[u] = parents_[parents_[u]];
+      u = parents_[u];
+    }
+
+    return u;
+  }
+
+  // merges the orbits of u and v, returns false if they were one already
+  bool unite(int u, int v) {
+    int a = find(u);
+    int b = find(v);
+
+    if (a == b) {
+      return false;
+    }
+
+    if (b < a) {
+      std::swap(a, b);
+    }
+
+    parents_[b] = a;
+
+    if (marked_[b]) {
+      marked_[a] = true;
+    }
+
+    orbit_count_ -= 1;
+
+    return true;
+  }
+
+  // merges the orbit of each u with the one of x[u]
+  void unite_all(const int *x) {
+    for (int u = 0; u < size(); u++) {
+      unite(u, x[u]);
+    }
+  }
+
+  int orbit_count() const {
+    return orbit_count_;
+  }
+
+  void mark(int u) {
+    marked_[find(u)] = true;
+  }
+
+  bool is_marked(int u) {
+    return marked_[find(u)];
+  }
+
+ private:
+  std::vector<int> parents_;
+  std::vector<char> marked_;
+  int orbit_count_;
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_ORBITS_H_
@@ -0,0 +1,68 @@
+#ifndef INCLUDE_NISHE_PACKEDDIRECTEDGRAPH_H_
+#define INCLUDE_NISHE_PACKEDDIRECTEDGRAPH_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Graph.h>
+#include <nishe/DirectedGraph.h>
+
+#include <cassert>
+
+namespace nishe {
+
+/*
+ * Represents a directed graph the same way DirectedGraph does, but with
+ * each nbhr packed into a single vertex wide word: the vertex is shifted up
+ * by TYPE_BITS and the arc type (IN, OUT, or BOTH) is kept in the low bits.
+ *
+ * A nbhr is then 4 bytes (8 with 64 bit vertices) instead of a pair, at the
+ * cost of the top TYPE_BITS bits of the vertices (so at most 2^30 vertices
+ * with 32 bit vertices).
+ *
+ * The degree sums are the same (in, out, both) triplets as DirectedGraph's,
+ * so the two refine identically.
+ */
+class PackedDirectedGraph: public Graph<PackedDirectedGraph, vertex_t,
+    unsigned int, InOutBoth> {
+ public:
+  static const unsigned int IN;
+  static const unsigned int OUT;
+  static const unsigned int BOTH;
+
+  // the number of low bits of a nbhr holding the arc type
+  static const int TYPE_BITS = 2;
+
+  // the largest vertex that fits in a nbhr
+  static vertex_t max_vertex() {
+    return static_cast<PackedDirectedGraph::nbhr>(-1) >> TYPE_BITS;
+  }
+
+  // adds the arc (u, v) to the graph, failing if u or v is above max_vertex()
+  // returns false if the arc cannot be added (it already exists)
+  bool add_arc(vertex_t u, vertex_t v);
+
+  // decode a nbhr without needing a graph
+  static vertex_t vertex_of(const PackedDirectedGraph::nbhr &nbhr) {
+    return nbhr >> TYPE_BITS;
+  }
+
+  static PackedDirectedGraph::attr attr_of(
+      const PackedDirectedGraph::nbhr &nbhr) {
+    return nbhr & ((1 << TYPE_BITS) - 1);
+  }
+
+  static PackedDirectedGraph::nbhr make_nbhr(vertex_t v,
+      PackedDirectedGraph::attr type) {
+    // the top bits of v would be shifted out
+    assert(v <= max_vertex());
+
+    return (v << TYPE_BITS) | type;
+  }
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_PACKEDDIRECTEDGRAPH_H_
@@ -37,12 +37,36 @@ class PartitionNest {
   // [ 0 1 ... n - 1 ]
   int unit(int n);
 
+  // sets this partition nest to have one cell per color, where colors[u] is
+  // the color of u, with the cells in increasing order of color
+  // (and each cell in increasing order)
+  int colored(int n, const unsigned int *colors);
+
   int size() const;  // number of elements
   int length() const;  // number of cells at the current level
   int cell_size(int k) const;  // size of cell at index k
 
   int index_containing(int u) const;  // the index containing the element u
-  int *elements();  // returns a pointer to the elements
+  int position_of(int u) const;  // where u is in elements()
+
+  // returns a pointer to the elements, after changing any of them directly
+  // call refresh_positions on the range changed
+  int *elements();
+  const int *elements() const;
+
+  // swaps the elements at positions i and j (which should be in one cell)
+  void swap_elements(int i, int j) {
+    int u = elements_[i];
+    int v = elements_[j];
+
+    elements_[i] = v;
+    elements_[j] = u;
+    positions_[v] = i;
+    positions_[u] = j;
+  }
+
+  // recomputes position_of for the elements at positions start ... end - 1
+  void refresh_positions(int start, int end);
 
   int level();  // the current level of the partition nest
 
@@ -90,6 +114,8 @@ class PartitionNest {
   int backup_level();  // recovers one level
 
   // splits the cell u is in, returns true if its cell was not trivial
+  // u is moved to the front of its cell and split off as its own cell, in
+  // O(1): u is found by position_of() and is the only element relabeled
   bool breakout(int u);
 
   void input_string(string s);
@@ -104,7 +130,17 @@ class PartitionNest {
   // the elements of the partition nest at the current level
   vector<int> elements_;
 
-  vector<int> index_containing_;  // the index_containing() lookup
+  /*
+   * Each cell has an id, and index_containing(u) is the start of the cell
+   * whose id is cell_ids_[u]. A split gives a new id to the smaller part
+   * (and a merge keeps the larger part's), so only the elements of the
+   * smaller part are relabeled: breaking out a vertex relabels just it.
+   */
+  vector<int> cell_ids_;
+  vector<int> cell_starts_;
+  vector<int> free_cell_ids_;
+
+  vector<int> positions_;  // the position_of() lookup, inverse of elements_
   vector<int> cell_sizes_;  // the cell_size() lookup
 
   deque<int> new_index_queue_;
@@ -120,7 +156,8 @@ class PartitionNest {
   // a doubly linked list keeping track of the nontrivial cells
   vector<pair<int, int> > nontrivial_list_;
 
-  void commit_index(int nStart, int k, int k_next);
+  void commit_index(int nStart, int k);
+  void relabel_cell(int start, int end, int id);
   void insert_index(int nStart, int k, int nStartSize);
   void erase_index(int nStart, int k, int nStartSize, int k_size);
 };
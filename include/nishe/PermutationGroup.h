@@ -0,0 +1,134 @@
+#ifndef INCLUDE_NISHE_PERMUTATIONGROUP_H_
+#define INCLUDE_NISHE_PERMUTATIONGROUP_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/BigInt.h>
+
+#include <vector>
+
+namespace nishe {
+
+/*
+ * A group of permutations of 0 ... n - 1, kept as a base b_0, b_1, ...
+ * and a strong generating set, built by the randomized Schreier-Sims
+ * algorithm as generators are added.
+ *
+ * Each generator is a strong generator of the stabilizers of b_0 ... b_i
+ * for every i below its level (the first base point it moves). The basic
+ * orbit of b_i (its orbit under the strong generators fixing b_0 ...
+ * b_(i - 1)) is stored as a Schreier vector, so membership is tested by
+ * sifting through the chain, and the order is the product of the basic
+ * orbit sizes.
+ *
+ * After a generator is added, random elements of the group (by product
+ * replacement) are sifted until completion_rounds() of them in a row sift
+ * to the identity, adding the residues that don't as strong generators.
+ * If the chain is still incomplete, each random element sifts with
+ * probability at most 1 / 2, so the order is right with probability at
+ * least 1 - 2^-completion_rounds(). An incomplete chain only undercounts:
+ * every strong generator is in the group.
+ *
+ * Permutations are int arrays, x[u] the image of u, and compose left to
+ * right (xy is x, then y).
+ */
+class PermutationGroup {
+ public:
+  PermutationGroup();
+
+  // the trivial group on n points, with base_prefix as the first base points
+  void reset(int n);
+  void reset(int n, const std::vector<int> &base_prefix);
+
+  int degree() const {
+    return degree_;
+  }
+
+  /*
+   * Adds x to the group, returns false if it was already in it (as far as
+   * the chain knows). Otherwise completes the chain.
+   */
+  bool add_generator(const int *x);
+
+  // whether x is in the group (exactly, for a complete chain)
+  bool contains(const int *x) const;
+
+  BigInt order() const;
+
+  const std::vector<int> &base() const {
+    return base_;
+  }
+
+  // the strong generators, in the order they were added
+  int generator_count() const {
+    return generators_.size();
+  }
+
+  const std::vector<int> &generator(int g) const {
+    return generators_[g];
+  }
+
+  // the first base point generator g moves
+  int generator_level(int g) const {
+    return generator_levels_[g];
+  }
+
+  // the size of the basic orbit of base()[i]
+  int basic_orbit_size(int i) const {
+    return basic_orbits_[i].size();
+  }
+
+  void set_completion_rounds(int rounds) {
+    completion_rounds_ = rounds;
+  }
+
+  int completion_rounds() const {
+    return completion_rounds_;
+  }
+
+ private:
+  // the entries of a Schreier vector that aren't generators
+  static const int NOT_IN_ORBIT;
+  static const int BASE_POINT;
+
+  int degree_;
+  int completion_rounds_;
+
+  std::vector<int> base_;
+
+  std::vector<std::vector<int> > generators_;
+  std::vector<std::vector<int> > inverses_;
+  std::vector<int> generator_levels_;
+
+  /*
+   * For each base point b_i, schreier_vectors_[i][u] is the generator that
+   * takes a point nearer b_i to u (BASE_POINT for b_i, NOT_IN_ORBIT for the
+   * points outside the basic orbit), and basic_orbits_[i] lists the orbit.
+   */
+  std::vector<std::vector<int> > schreier_vectors_;
+  std::vector<std::vector<int> > basic_orbits_;
+
+  // the product replacement state: the elements and their running product
+  std::vector<std::vector<int> > random_elements_;
+  std::vector<int> random_product_;
+  unsigned int random_seed_;
+
+  std::vector<int> scratch_;
+
+  void add_base_point(int u);
+  void add_strong_generator(const std::vector<int> &x, int level);
+  void update_basic_orbit(int i);
+  int sift(std::vector<int> *x_ptr) const;
+  int first_moved_point(const std::vector<int> &x) const;
+  bool is_identity(const std::vector<int> &x) const;
+  unsigned int next_random();
+  void random_element(std::vector<int> *x_ptr);
+  void complete();
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_PERMUTATIONGROUP_H_
@@ -0,0 +1,282 @@
+#ifndef INCLUDE_NISHE_REFINETRACEHASH_H_
+#define INCLUDE_NISHE_REFINETRACEHASH_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/ColorDegreeSum.h>
+#include <nishe/DirectedGraph.h>
+#include <nishe/Graph.h>
+#include <nishe/MapDegreeSum.h>
+#include <nishe/RefineTraceValue.h>
+
+#include <stdint.h>
+
+#include <cassert>
+#include <map>
+#include <vector>
+
+namespace nishe {
+
+// mixes x into the hash h (a multiply and xorshift, like splitmix64's)
+inline uint64_t hash_mix(uint64_t h, uint64_t x) {
+  h = (h ^ x) * 0xff51afd7ed558ccdULL;
+  return h ^ (h >> 32);
+}
+
+/*
+ * Mixes an attr_sum into a hash. A new attr_sum type needs one of these to
+ * be traced by RefineTraceHash.
+ */
+inline uint64_t hash_attr_sum(uint64_t h, vertex_t attr_sum) {
+  return hash_mix(h, attr_sum);
+}
+
+inline uint64_t hash_attr_sum(uint64_t h, const InOutBoth &attr_sum) {
+  for (int i = 0; i < 3; i++) {
+    h = hash_mix(h, attr_sum.weights[i]);
+  }
+
+  return h;
+}
+
+template<int kColors>
+uint64_t hash_attr_sum(uint64_t h, const ColorDegreeSum<kColors> &attr_sum) {
+  for (int i = 0; i < kColors; i++) {
+    h = hash_mix(h, attr_sum.counts[i]);
+  }
+
+  return h;
+}
+
+template<typename weight_t>
+uint64_t hash_attr_sum(uint64_t h, const MapDegreeSum<weight_t> &attr_sum) {
+  typename std::map<weight_t, size_t>::const_iterator it;
+
+  for (it = attr_sum.weight_map.begin(); it != attr_sum.weight_map.end();
+       it++) {
+    h = hash_mix(hash_mix(h, it->first), it->second);
+  }
+
+  return hash_mix(h, attr_sum.weight_map.size());
+}
+
+/*
+ * A compact refine trace, which the refiner uses in place of a
+ * RefineTraceValue (Refiner<graph_t, RefineTraceHash<graph_t> >).
+ *
+ * Instead of every attr_sum, it keeps each active index and a 64 bit hash
+ * of the attr_sums traced while sowing it (a checkpoint per active index),
+ * so it takes 16 bytes per active index no matter how much was split.
+ * Traces are ordered by their checkpoints, comparing the active indices
+ * and then the hashes as numbers. That is not the order of the full trace,
+ * but it is as consistent: it only depends on what was traced. A
+ * refinement can only tell its trace is larger at the end of an active
+ * index (when its checkpoint is done), rather than at the attr_sum that
+ * differs.
+ *
+ * Two different traces with the same checkpoints compare as equal. With
+ * set_keep_full(true), a full RefineTraceValue is kept as well when a
+ * trace is recorded from scratch. cmp() falls back on it when the
+ * checkpoints tie. A trace that was only partly recorded (it started out
+ * equal to another and then became smaller) has no full trace to fall
+ * back on.
+ */
+template<typename graph_t>
+class RefineTraceHash {
+ public:
+  RefineTraceHash() :
+    clear_(true), keep_full_(false), has_full_(false), step_hash_(0) {
+  }
+
+  void set_keep_full(bool keep_full) {
+    keep_full_ = keep_full;
+  }
+
+  void clear() {
+    steps_.clear();
+    full_.clear();
+    has_full_ = false;
+    clear_ = true;
+  }
+
+  bool is_clear() {
+    return clear_;
+  }
+
+  void set_clear(bool flag) {
+    // a trace recorded from scratch can keep a full copy
+    if (clear_ && !flag && keep_full_) {
+      full_.clear();
+      full_.set_clear(false);
+      has_full_ = true;
+    }
+
+    clear_ = flag;
+  }
+
+  // the number of active indices traced
+  int size() const {
+    return steps_.size();
+  }
+
+  // a hash of the whole trace
+  uint64_t hash() const {
+    uint64_t h = steps_.size();
+
+    for (int i = 0; i < steps_.size(); i++) {
+      h = hash_mix(hash_mix(h, steps_[i].active_index), steps_[i].hash);
+    }
+
+    return h;
+  }
+
+  int cmp(const RefineTraceHash<graph_t> &b) const;
+
+  // see RefineTraceValue
+  void trace_active_index(int k, int active_count, int *cmp_ptr);
+  void trace_attr_sum(int active_count, int adjacent_index,
+      const typename graph_t::attr_sum &attr_sum, int attr_sum_count,
+      int *cmp_ptr);
+  void trace_invariant(int active_count, int index, vertex_t invariant,
+      int invariant_count, int *cmp_ptr);
+  void finish_active_index(int active_count, int *cmp_ptr);
+
+ private:
+  // an active index and the hash of what sowing it traced
+  struct Step {
+    int active_index;
+    uint64_t hash;
+  };
+
+  bool clear_;
+  bool keep_full_;
+  bool has_full_;
+
+  std::vector<Step> steps_;
+
+  // the hash of the active index being sown so far
+  uint64_t step_hash_;
+
+  RefineTraceValue<graph_t> full_;
+};
+
+template<typename graph_t>
+int RefineTraceHash<graph_t>::cmp(const RefineTraceHash<graph_t> &b) const {
+  for (int i = 0; i < steps_.size(); i++) {
+    // if there are not enough active indices in the other
+    if (b.steps_.size() <= i) {
+      return 1;
+    }
+
+    if (steps_[i].active_index != b.steps_[i].active_index) {
+      return steps_[i].active_index < b.steps_[i].active_index ? -1 : 1;
+    }
+
+    if (steps_[i].hash != b.steps_[i].hash) {
+      return steps_[i].hash < b.steps_[i].hash ? -1 : 1;
+    }
+  }
+
+  if (steps_.size() < b.steps_.size()) {
+    return -1;
+  }
+
+  // the checkpoints tie, so fall back on the full traces if there are any
+  if (has_full_ && b.has_full_) {
+    return full_.cmp(b.full_);
+  }
+
+  return 0;
+}
+
+template<typename graph_t>
+void RefineTraceHash<graph_t>::trace_active_index(int k, int active_count,
+    int *cmp_ptr) {
+  assert(*cmp_ptr != 1);
+
+  if (*cmp_ptr == 0) {
+    // if there are not enough indices in the trace
+    // the current trace is larger
+    if (steps_.size() <= active_count) {
+      *cmp_ptr = 1;
+      return;
+    }
+
+    int k_trace = steps_[active_count].active_index;
+
+    if (k > k_trace) {
+      *cmp_ptr = 1;
+      return;
+    } else if (k < k_trace) {
+      *cmp_ptr = -1;
+      has_full_ = false;
+    }
+  }
+
+  if (*cmp_ptr == -1) {
+    Step step = {k, 0};
+
+    steps_.resize(active_count);
+    steps_.push_back(step);
+
+    if (has_full_) {
+      full_.trace_active_index(k, active_count, cmp_ptr);
+    }
+  }
+
+  step_hash_ = hash_mix(0, k);
+}
+
+template<typename graph_t>
+void RefineTraceHash<graph_t>::trace_attr_sum(int active_count,
+    int adjacent_index, const typename graph_t::attr_sum &attr_sum,
+    int attr_sum_count, int *cmp_ptr) {
+  step_hash_ = hash_attr_sum(hash_mix(step_hash_, adjacent_index), attr_sum);
+
+  if (*cmp_ptr == -1 && has_full_) {
+    full_.trace_attr_sum(active_count, adjacent_index, attr_sum,
+        attr_sum_count, cmp_ptr);
+  }
+}
+
+template<typename graph_t>
+void RefineTraceHash<graph_t>::trace_invariant(int active_count, int index,
+    vertex_t invariant, int invariant_count, int *cmp_ptr) {
+  step_hash_ = hash_mix(hash_mix(step_hash_, index), invariant);
+
+  if (*cmp_ptr == -1 && has_full_) {
+    full_.trace_invariant(active_count, index, invariant, invariant_count,
+        cmp_ptr);
+  }
+}
+
+template<typename graph_t>
+void RefineTraceHash<graph_t>::finish_active_index(int active_count,
+    int *cmp_ptr) {
+  assert(*cmp_ptr != 1);
+
+  if (*cmp_ptr == 0) {
+    uint64_t hash_trace = steps_[active_count].hash;
+
+    if (step_hash_ > hash_trace) {
+      *cmp_ptr = 1;
+      return;
+    } else if (step_hash_ < hash_trace) {
+      // everything after this active index is recorded from now on
+      *cmp_ptr = -1;
+      has_full_ = false;
+      steps_.resize(active_count + 1);
+    }
+  }
+
+  if (*cmp_ptr == -1) {
+    steps_[active_count].hash = step_hash_;
+  }
+}
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_REFINETRACEHASH_H_
@@ -6,6 +6,9 @@
     Released under the Lesser General Public License v3.
 */
 
+#include <nishe/Graph.h>
+
+#include <cassert>
 #include <vector>
 #include <utility>
 
@@ -19,6 +22,9 @@ using std::pair;
  * The refiner goes through the active indices, stored in affected_indices
  * For each affected index, store the vector of indices this index's nbhrs.
  *
+ * A step that split the cells by a vertex invariant instead of sowing an
+ * active index stores the vertex invariant of each new cell in
+ * adjacent_invariants (and has no attr_sums).
  */
 
 template<typename graph_t>
@@ -30,14 +36,41 @@ class RefineTraceValue {
 
   /*
    * RefineTraceValues are first compared lexicographically by
-   * the active_indices and then by the index sums for each active
-   * index.
+   * the active_indices and then by the index sums (and the index
+   * invariants) for each active index.
+   */
+  int cmp(const RefineTraceValue<graph_t> &a) const;
+
+  /*
+   * What the refiner calls as it goes. Each one compares what it is given
+   * to what is in the trace at that point (*cmp_ptr == 0) and sets *cmp_ptr
+   * to 1 if the refinement's trace is larger, or to -1 if it is smaller,
+   * in which case the trace is cut off there and recorded from then on
+   * (*cmp_ptr == -1). *cmp_ptr is never 1 when these are called.
    */
-  int cmp(const RefineTraceValue<graph_t> &a);
+
+  // the active_count-th active index is k
+  void trace_active_index(int k, int active_count, int *cmp_ptr);
+
+  // splitting the cell at adjacent_index gave a cell with attr_sum, which
+  // is the attr_sum_count-th attr_sum traced for the active index
+  void trace_attr_sum(int active_count, int adjacent_index,
+      const typename graph_t::attr_sum &attr_sum, int attr_sum_count,
+      int *cmp_ptr);
+
+  // splitting the cell at index by a vertex invariant gave a cell with the
+  // value invariant, the invariant_count-th one traced for the active index
+  void trace_invariant(int active_count, int index, vertex_t invariant,
+      int invariant_count, int *cmp_ptr);
+
+  // the active_count-th active index has been sown and split by
+  void finish_active_index(int active_count, int *cmp_ptr) {
+  }
 
   void clear() {
     active_indices.clear();
     adjacent_attr_sums.clear();
+    adjacent_invariants.clear();
     clear_ = true;
   }
 
@@ -52,11 +85,13 @@ class RefineTraceValue {
   void push_active_index(int k) {
     active_indices.push_back(k);
     adjacent_attr_sums.resize(active_indices.size());
+    adjacent_invariants.resize(active_indices.size());
   }
 
   void resize(int n) {
     active_indices.resize(n);
     adjacent_attr_sums.resize(n);
+    adjacent_invariants.resize(n);
   }
 
   bool clear_;
@@ -69,6 +104,25 @@ class RefineTraceValue {
 
   // for each affected index, stores the list list of index_sums
   vector<vector<index_attr_sum> > adjacent_attr_sums;
+
+  // pair of an index and the vertex invariant of the cell there
+  typedef pair<int, vertex_t> index_invariant;
+
+  // for each affected index, the index_invariants it split by (if any)
+  vector<vector<index_invariant> > adjacent_invariants;
+
+ private:
+  // the index_invariants of the ith active index, none if not there
+  const vector<index_invariant> &invariants_at(int i) const {
+    static const vector<index_invariant> no_invariants;
+
+    return i < adjacent_invariants.size() ? adjacent_invariants[i] :
+        no_invariants;
+  }
+
+  template<typename entry_t>
+  void trace_entry(vector<vector<entry_t> > *adjacent_entries_ptr,
+      int active_count, const entry_t &entry, int entry_count, int *cmp_ptr);
 };
 
 template<typename T>
@@ -82,8 +136,31 @@ static int compare(const T &a, const T &b) {
   return 0;
 }
 
+// compares the entries one active index traced, a shorter list is smaller
+template<typename entry_t>
+static int compare_entries(const vector<entry_t> &entries,
+    const vector<entry_t> &b_entries) {
+  for (int j = 0; j < entries.size(); j++) {
+    // if there are not enough adjacent entries
+    if (b_entries.size() <= j) {
+      return 1;
+    }
+
+    if (entries[j] != b_entries[j]) {
+      return compare(entries[j], b_entries[j]);
+    }
+  }
+
+  // if we still have more in b
+  if (entries.size() < b_entries.size()) {
+    return -1;
+  }
+
+  return 0;
+}
+
 template<typename graph_t>
-int RefineTraceValue<graph_t>::cmp(const RefineTraceValue<graph_t> &b) {
+int RefineTraceValue<graph_t>::cmp(const RefineTraceValue<graph_t> &b) const {
   for (int i = 0; i < active_indices.size(); i++) {
     // if there are not enough active indices in the other
     if (b.active_indices.size() <= i) {
@@ -94,23 +171,15 @@ int RefineTraceValue<graph_t>::cmp(const RefineTraceValue<graph_t> &b) {
       return compare(active_indices[i], b.active_indices[i]);
     }
 
-    const vector<index_attr_sum> &attr_sums = adjacent_attr_sums.at(i);
-    const vector<index_attr_sum> &b_attr_sums = b.adjacent_attr_sums.at(i);
+    int diff = compare_entries(adjacent_attr_sums.at(i),
+        b.adjacent_attr_sums.at(i));
 
-    for (int j = 0; j < attr_sums.size(); j++) {
-      // if there are not enough adjacent nbhr sums
-      if (b_attr_sums.size() <= j) {
-        return 1;
-      }
-
-      if (attr_sums[j] != b_attr_sums[j]) {
-        return compare(attr_sums[j], b_attr_sums[j]);
-      }
+    if (diff == 0) {
+      diff = compare_entries(invariants_at(i), b.invariants_at(i));
     }
 
-    // if we still have more in b
-    if (attr_sums.size() < b_attr_sums.size()) {
-      return -1;
+    if (diff != 0) {
+      return diff;
     }
   }
 
@@ -121,4 +190,92 @@ int RefineTraceValue<graph_t>::cmp(const RefineTraceValue<graph_t> &b) {
   return 0;
 }
 
+template<typename graph_t>
+void RefineTraceValue<graph_t>::trace_active_index(int k, int active_count,
+    int *cmp_ptr) {
+  assert(*cmp_ptr != 1);
+
+  if (*cmp_ptr == 0) {
+    // if there are not enough indices in the trace
+    // the current trace is larger
+    if (active_indices.size() <= active_count) {
+      *cmp_ptr = 1;
+      return;
+    } else {
+      int k_trace = active_indices[active_count];
+
+      // if our index is smaller than what's in the trace
+      if (k < k_trace) {
+        *cmp_ptr = -1;
+        resize(active_count);
+      } else if (k > k_trace) {  // otherwise if it's larger
+        *cmp_ptr = 1;
+        return;
+      }
+    }
+  }
+
+  if (*cmp_ptr == -1) {
+    push_active_index(k);
+  }
+}
+
+template<typename graph_t>
+void RefineTraceValue<graph_t>::trace_attr_sum(int active_count,
+    int adjacent_index, const typename graph_t::attr_sum &attr_sum,
+    int attr_sum_count, int *cmp_ptr) {
+  trace_entry(&adjacent_attr_sums, active_count,
+      index_attr_sum(adjacent_index, attr_sum), attr_sum_count, cmp_ptr);
+}
+
+template<typename graph_t>
+void RefineTraceValue<graph_t>::trace_invariant(int active_count, int index,
+    vertex_t invariant, int invariant_count, int *cmp_ptr) {
+  trace_entry(&adjacent_invariants, active_count,
+      index_invariant(index, invariant), invariant_count, cmp_ptr);
+}
+
+/*
+ * Traces the entry_count-th entry of the active_count-th active index, in
+ * either adjacent_attr_sums or adjacent_invariants.
+ */
+template<typename graph_t>
+template<typename entry_t>
+void RefineTraceValue<graph_t>::trace_entry(
+    vector<vector<entry_t> > *adjacent_entries_ptr, int active_count,
+    const entry_t &entry, int entry_count, int *cmp_ptr) {
+  vector<vector<entry_t> > &adjacent_entries = *adjacent_entries_ptr;
+
+  assert(*cmp_ptr != 1);
+
+  // if there are no more entries in the trace the current trace is larger
+  if (*cmp_ptr == 0 && adjacent_entries[active_count].size()
+      <= entry_count) {
+    *cmp_ptr = 1;
+    return;
+  }
+
+  if (*cmp_ptr == 0) {
+    const entry_t &curr_entry = adjacent_entries[active_count][entry_count];
+
+    // if we're larger than what's already there :(
+    if (entry > curr_entry) {
+      *cmp_ptr = 1;
+      return;
+    } else if (entry < curr_entry) {
+      // if we're smaller than what's already there :)
+      *cmp_ptr = -1;
+
+      // cut off everything past this active index
+      resize(active_count + 1);
+      adjacent_entries.at(active_count).resize(entry_count);
+    }
+  }
+
+  // if we're adding to the trace, just append the entry
+  if (*cmp_ptr == -1) {
+    adjacent_entries.at(active_count).push_back(entry);
+  }
+}
+
 #endif  // INCLUDE_NISHE_REFINETRACEVALUE_H_
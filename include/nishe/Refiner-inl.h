@@ -17,108 +17,124 @@
 
 namespace nishe {
 
-static void nontrivial_indices(const PartitionNest &pi, vector<int> *v) {
+inline void nontrivial_indices(const PartitionNest &pi, ActiveIndices *v) {
   int k = 0;
 
   while (k != pi.terminal_index()) {
-    (*v).push_back(k);
+    v->push(k, pi.cell_size(k));
     k = pi.next_index(k);
   }
 }
 
 /*
- * Checks trace_ptr to see if the index k matches what's present in its own trace.
- * It sets cmp_ptr accordingly and returns false if *cmp_ptr ends up 1
- * Assumes that we never pass in *cmp_ptr == 1
+ * Sows the nbhds of the vertices cell[0] ... cell[cell_size - 1] into the
+ * workspace's attr_sums one nbhr at a time, keeping track of which vertices
+ * were sown to.
  */
 template<typename graph_t>
-static void trace_active_index(int k, int active_count, RefineTraceValue<
-    graph_t> *trace_ptr, int *cmp_ptr) {
-  assert(*cmp_ptr != 1);
-
-  if (*cmp_ptr == 0) {
-    // if there are not enough indices in trace_ptr
-    // the current trace is larger
-    if (trace_ptr->active_indices.size() <= active_count) {
-      *cmp_ptr = 1;
-      return;
-    } else {
-      int k_trace = trace_ptr->active_indices[active_count];
-
-      // if our index is smaller than what's in the trace
-      if (k < k_trace) {
-        *cmp_ptr = -1;
-        trace_ptr->resize(active_count);
-      } else if (k > k_trace) {  // otherwise if it's larger
-        *cmp_ptr = 1;
-        return;
+void sow_nbhds(const graph_t &G, const int *cell, int cell_size,
+    RefinerWorkspace<typename graph_t::attr_sum> *workspace_ptr) {
+  vector<typename graph_t::attr_sum> &attr_sums = workspace_ptr->attr_sums;
+  TouchedSet &touched_vertices = workspace_ptr->touched_vertices;
+
+  for (int i = 0; i < cell_size; i++) {
+    const typename graph_t::nbhr *nbhd = G.get_nbhd(cell[i]);
+    int nbhd_size = G.get_nbhd_size(cell[i]);
+
+    // decode through the static accessors so this loop inlines
+    for (int j = 0; j < nbhd_size; j++) {
+      typename graph_t::vertex v = graph_t::vertex_of(nbhd[j]);
+
+      // a stale attr_sum is reset the first time v is sown to
+      if (touched_vertices.touch(v)) {
+        attr_sums[v] = 0;
       }
-    }
-  }
 
-  if (*cmp_ptr == -1) {
-    trace_ptr->push_active_index(k);
+      attr_sums[v] += graph_t::attr_of(nbhd[j]);
+    }
   }
 }
 
+/*
+ * Sows a cell for the refiner. A graph type with a faster way to compute
+ * the attr_sums of a whole cell (like DenseGraph) overloads this.
+ */
 template<typename graph_t>
-static void trace_attr_sum(int active_index, int adjacent_index,
-    const typename graph_t::attr_sum &attr_sum, int attr_sum_count,
-    RefineTraceValue<graph_t> *trace_ptr, int *cmp_ptr) {
-  // this type is a mouthfull... so typedef it real quick
-  typedef typename RefineTraceValue<graph_t>::index_attr_sum index_attr_sum;
-
-  index_attr_sum adjacent_sum(adjacent_index, attr_sum);
+void sow_cell(const graph_t &G, const int *cell, int cell_size,
+    RefinerWorkspace<typename graph_t::attr_sum> *workspace_ptr) {
+  sow_nbhds(G, cell, cell_size, workspace_ptr);
+}
 
-  // cmp should never == 1
-  assert(!cmp_ptr != 1);
+template<typename graph_t, typename trace_t>
+const int Refiner<graph_t, trace_t>::INVARIANT_INDEX = -1;
 
-  if (*cmp_ptr == 0) {
-    index_attr_sum &curr_adjacent_sum =
-        trace_ptr->adjacent_attr_sums[active_index][attr_sum_count];
+template<typename graph_t, typename trace_t>
+Refiner<graph_t, trace_t>::Refiner() :
+  skip_largest(false), invariant(NO_INVARIANT), invariant_arg(0) {
+  empty_attr_sum = 0;
+}
 
-    // if we're larger than what's already there :(
-    if (adjacent_sum > curr_adjacent_sum) {
-      *cmp_ptr = 1;
-      return;
-    } else if (adjacent_sum < curr_adjacent_sum) {
-      // if we're smaller than what's already there :)
-      *cmp_ptr = -1;
+/*
+ * With skip_largest set, a split cell that is not waiting to be an active
+ * index itself queues every fragment but the largest one (the first of the
+ * largest ones if there's a tie), instead of every fragment but the first.
+ *
+ * Sowing the parent cell was already done (or wasn't needed), and the
+ * largest fragment's effect is the parent's minus the other fragments', so
+ * the result is equitable either way. Each vertex is then only in an active
+ * cell O(log n) times, giving O(m log n) refinement (Hopcroft's rule).
+ * Which fragment is skipped only depends on the cell sizes and indices, so
+ * the trace stays canonical, but it is a different trace than the one
+ * without skip_largest.
+ */
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::set_skip_largest(bool skip_largest) {
+  this->skip_largest = skip_largest;
+}
 
-      // cut off everything past this active index
-      trace_ptr->resize(active_index + 1);
-      trace_ptr->adjacent_attr_sums.at(active_index).resize(attr_sum_count);
-    }
-  }
+/*
+ * The order the active indices are sown in (LIFO by default). Traces are
+ * only comparable between refinements done in the same order.
+ */
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::set_order(ActiveIndices::Order order) {
+  workspace.active_indices.set_order(order);
+}
 
-  // if we're adding to the trace, just append the index and sum
-  if (*cmp_ptr == -1) {
-    trace_ptr->adjacent_attr_sums.at(active_index).push_back(adjacent_sum);
-  }
+/*
+ * Once there are no active indices left (the partition is equitable), the
+ * nontrivial cells are split by the vertex invariant (see
+ * VertexInvariant.h) and refining goes on from the new cells. This is done
+ * once per refinement, as a step of its own in the trace, with an active
+ * index of INVARIANT_INDEX and the invariant of each new cell traced in
+ * place of attr_sums. NO_INVARIANT turns it off.
+ */
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::set_invariant(VertexInvariant invariant,
+    int arg) {
+  this->invariant = invariant;
+  invariant_arg = arg;
 }
 
-template<typename graph_t>
-int Refiner<graph_t>::refine(const graph_t &G, PartitionNest *pi_ptr,
-    RefineTraceValue<graph_t> *trace_ptr, int initial_active_index) {
-  vector<int> active_indices;
+template<typename graph_t, typename trace_t>
+int Refiner<graph_t, trace_t>::refine(const graph_t &G, PartitionNest *pi_ptr,
+    trace_t *trace_ptr, int initial_active_index) {
+  workspace.reserve(G.vertex_count());
 
   // add every index if the initial one isn't specified
   if (initial_active_index == -1) {
-    nontrivial_indices(*pi_ptr, &active_indices);
+    nontrivial_indices(*pi_ptr, &workspace.active_indices);
   } else {
-    active_indices.push_back(initial_active_index);
+    workspace.active_indices.push(initial_active_index,
+        pi_ptr->cell_size(initial_active_index));
   }
 
-  if (attr_sums.size() < G.vertex_count()) {
-    attr_sums.resize(G.vertex_count());
-  }
-
-  return refine(G, pi_ptr, trace_ptr, &active_indices);
+  return refine(G, pi_ptr, trace_ptr, &workspace.active_indices);
 }
 
-template<typename graph_t>
-int Refiner<graph_t>::refine(const graph_t &G, PartitionNest *pi_ptr,
-    RefineTraceValue<graph_t> *trace_ptr, vector<int> *active_indices_ptr) {
+template<typename graph_t, typename trace_t>
+int Refiner<graph_t, trace_t>::refine(const graph_t &G, PartitionNest *pi_ptr,
+    trace_t *trace_ptr, ActiveIndices *active_indices_ptr) {
   // assume initially that the traces will be equal
   int cmp = 0;
 
@@ -129,29 +145,51 @@ int Refiner<graph_t>::refine(const graph_t &G, PartitionNest *pi_ptr,
   }
 
   int active_count = 0;
+  bool is_invariant_done = invariant == NO_INVARIANT;
+
+  while (true) {
+    // when equitable, split by the invariant (once) if it could do anything
+    bool is_invariant_step = active_indices_ptr->empty();
 
-  while (active_indices_ptr->size() > 0) {
-    int k = active_indices_ptr->back();
-    active_indices_ptr->pop_back();
+    if (is_invariant_step && (is_invariant_done || pi_ptr->is_discrete())) {
+      break;
+    }
 
-    trace_active_index(k, active_count, trace_ptr, &cmp);
+    int k = is_invariant_step ? INVARIANT_INDEX : active_indices_ptr->pop();
+
+    trace_ptr->trace_active_index(k, active_count, &cmp);
 
     // if we observe a larger active index
     if (cmp == 1) {
       break;
     }
 
-    split_with_index(k, active_count, G, pi_ptr, trace_ptr, active_indices_ptr,
-        &cmp);
+    if (is_invariant_step) {
+      split_with_invariant(active_count, G, pi_ptr, trace_ptr,
+          active_indices_ptr, &cmp);
+      is_invariant_done = true;
+    } else {
+      split_with_index(k, active_count, G, pi_ptr, trace_ptr,
+          active_indices_ptr, &cmp);
+    }
 
     // if we observed a larger attr_sum somewhere in there
     if (cmp == 1) {
       break;
     }
 
+    trace_ptr->finish_active_index(active_count, &cmp);
+
+    if (cmp == 1) {
+      break;
+    }
+
     active_count += 1;
   }
 
+  // forget the indices left by bailing
+  active_indices_ptr->clear();
+
   return cmp;
 }
 
@@ -159,154 +197,224 @@ int Refiner<graph_t>::refine(const graph_t &G, PartitionNest *pi_ptr,
  * Sows the contents of the active index and sorts each of the adjacent
  * indices based on the attr_sums.
  */
-template<typename graph_t>
-void Refiner<graph_t>::split_with_index(int active_index, int active_count,
-    const graph_t &G, PartitionNest *pi_ptr,
-    RefineTraceValue<graph_t> *trace_ptr, vector<int> *active_indices_ptr,
-    int *cmp_ptr) {
-  set<int> adjacent_indices;
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::split_with_index(int active_index,
+    int active_count, const graph_t &G, PartitionNest *pi_ptr,
+    trace_t *trace_ptr, ActiveIndices *active_indices_ptr, int *cmp_ptr) {
+  // sow the active cell, keeping track of which vertices were sown to
+  sow_cell(G, pi_ptr->elements() + active_index,
+      pi_ptr->cell_size(active_index), &workspace);
+
+  group_touched_vertices(pi_ptr);
+
+  // sort and split each adjacent index
+  sort_and_split_indices(active_count, pi_ptr, trace_ptr, active_indices_ptr,
+      cmp_ptr);
+
+  // nothing to erase, the next sow resets what it touches
+  workspace.touched_vertices.clear();
+  workspace.adjacent_indices.clear();
+}
+
+/*
+ * Splits each nontrivial cell by the vertex invariant, tracing the value
+ * of each new cell, and queues the new cells. The partition was equitable,
+ * so like a split cell that wasn't queued, one fragment of each cell can
+ * be left out.
+ */
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::split_with_invariant(int active_count,
+    const graph_t &G, PartitionNest *pi_ptr, trace_t *trace_ptr,
+    ActiveIndices *active_indices_ptr, int *cmp_ptr) {
+  const vector<vertex_t> &values = invariant_workspace.values;
+  const vector<int> &indices = invariant_workspace.indices;
+  int invariant_count = 0;
+
+  compute_vertex_invariant(G, *pi_ptr, invariant, invariant_arg,
+      &invariant_workspace);
+
+  for (int t = 0; t < indices.size(); t++) {
+    int k = indices[t];
+    int end = k + pi_ptr->cell_size(k);
+
+    workspace.new_indices.clear();
+
+    sort_by_attr_sum(pi_ptr->elements() + k, pi_ptr->elements() + end,
+        values, &workspace.sort_buffer);
+    pi_ptr->refresh_positions(k, end);
+
+    vertex_t prev_value = values[pi_ptr->elements()[k]];
+
+    trace_ptr->trace_invariant(active_count, k, prev_value, invariant_count,
+        cmp_ptr);
+    invariant_count += 1;
+
+    if (*cmp_ptr == 1) {
+      return;
+    }
 
-  // sow the active cell
-  for (int i = active_index;
-       i < active_index + pi_ptr->cell_size(active_index); i++) {
-    vertex_t u = pi_ptr->elements()[i];
-    const typename graph_t::nbhr *nbhd = G.get_nbhd(u);
+    for (int i = k + 1; i < end; i++) {
+      vertex_t value = values[pi_ptr->elements()[i]];
 
-    for (int j = 0; j < G.get_nbhd_size(u); j++) {
-      vertex_t v = G.nbhr_vertex(nbhd[j]);
+      if (value != prev_value) {
+        pi_ptr->enqueue_new_index(i);
+        workspace.new_indices.push_back(i);
+        prev_value = value;
 
-      attr_sums[v] += G.nbhr_attr(nbhd[j]);
+        trace_ptr->trace_invariant(active_count, i, value, invariant_count,
+            cmp_ptr);
+        invariant_count += 1;
 
-      // keep track of which indices were sown to for the trace
-      adjacent_indices.insert(pi_ptr->index_containing(v));
+        if (*cmp_ptr == 1) {
+          return;
+        }
+      }
     }
+
+    pi_ptr->commit_pending_indices();
+
+    queue_fragments(k, end, active_indices_ptr);
   }
+}
 
-  // sort and split each adjacent index
-  sort_and_split_indices(active_count, adjacent_indices, pi_ptr, trace_ptr,
-      active_indices_ptr, cmp_ptr);
+/*
+ * Finds the indices containing the touched vertices, and moves the touched
+ * vertices of each of those cells to its back. The rest of the cell was not
+ * sown to, so it all has an attr_sum of 0 and only the back has to be sorted.
+ */
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::group_touched_vertices(PartitionNest *pi_ptr) {
+  for (int t = 0; t < workspace.touched_vertices.size(); t++) {
+    int v = workspace.touched_vertices[t];
+    int k = pi_ptr->index_containing(v);
+
+    if (workspace.adjacent_indices.touch(k)) {
+      workspace.touched_counts[k] = 0;
+    }
+
+    workspace.touched_counts[k] += 1;
+
+    // v goes just before the touched vertices already at the back
+    pi_ptr->swap_elements(pi_ptr->position_of(v),
+        k + pi_ptr->cell_size(k) - workspace.touched_counts[k]);
+  }
 }
 
 /*
  * Goes through each adjacent index and sorts and splits the index
  * if it is required.
  */
-template<typename graph_t>
-void Refiner<graph_t>::sort_and_split_indices(int active_count,
-    const set<int> &adjacent_indices, PartitionNest *pi_ptr, RefineTraceValue<
-        graph_t> *trace_ptr, vector<int> *active_indices_ptr, int *cmp_ptr) {
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::sort_and_split_indices(int active_count,
+    PartitionNest *pi_ptr, trace_t *trace_ptr,
+    ActiveIndices *active_indices_ptr, int *cmp_ptr) {
   int attr_sum_count = 0;
 
   // go over the adjacent indices in sorted order (important for trace!)
-  for (set<int>::const_iterator it = adjacent_indices.begin(); it
-      != adjacent_indices.end(); it++) {
-    int adjacent_index = (*it);  // the adjacent index
+  workspace.adjacent_indices.sort();
+
+  for (int t = 0; t < workspace.adjacent_indices.size(); t++) {
+    int adjacent_index = workspace.adjacent_indices[t];  // the adjacent index
     int adjacent_cell_size = pi_ptr->cell_size(adjacent_index);
 
     // sort and split the cell k
     if (adjacent_cell_size > 1) {
-      sort_and_split_index(active_count, adjacent_index, pi_ptr, trace_ptr,
+      sort_and_split_index(active_count, adjacent_index,
+          workspace.touched_counts[adjacent_index], pi_ptr, trace_ptr,
           active_indices_ptr, &attr_sum_count, cmp_ptr);
     } else {  // pi_ptr->cell_size(k) == 1
       int u = pi_ptr->elements()[adjacent_index];
-      trace_attr_sum(active_count, adjacent_index, attr_sums[u],
-          attr_sum_count, trace_ptr, cmp_ptr);
-    }
-
-    // erase our tracks
-    for (int i = adjacent_index; i < adjacent_index + adjacent_cell_size; i++) {
-      int u = pi_ptr->elements()[i];
-      attr_sums[u] = 0;
+      trace_ptr->trace_attr_sum(active_count, adjacent_index,
+          workspace.attr_sums[u], attr_sum_count, cmp_ptr);
+      attr_sum_count += 1;
     }
 
+    // bail, split_with_index clears what was sown
     if (*cmp_ptr == 1) {
-      // clear what was sown
-      for (; it != adjacent_indices.end(); it++) {
-        adjacent_index = (*it);
-
-        for (int i = adjacent_index; i < adjacent_index + pi_ptr->cell_size(
-            adjacent_index); i++) {
-          int u = pi_ptr->elements()[i];
-          attr_sums[u] = 0;
-        }
-      }
-
-      // and bail
       return;
     }
   }
 }
 
 /*
- * A comparator to sort a cell based on attr_sums
+ * Splits a single nontrivial cell based on the attr_sums, where the last
+ * touched_count vertices of the cell are the ones that were sown to.
+ *
+ * Only those are sorted, the untouched ones (whose attr_sums are empty,
+ * the smallest attr_sum) already make up the first cell, so this costs
+ * O(t log t) for t touched vertices no matter how large the cell is.
  */
-template<typename graph_t>
-struct NbhrSumComparator {
-  vector<typename graph_t::attr_sum> *attr_sums_ptr;
-
-  explicit NbhrSumComparator(
-      vector<typename graph_t::attr_sum> *attr_sums_ptr) :
-    attr_sums_ptr(attr_sums_ptr) {
-  }
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::sort_and_split_index(int active_count, int k,
+    int touched_count, PartitionNest *pi_ptr,
+    trace_t *trace_ptr, ActiveIndices *active_indices_ptr,
+    int *attr_sum_count_ptr, int *cmp_ptr) {
+  int end = k + pi_ptr->cell_size(k);
+  int touched_start = end - touched_count;
+
+  workspace.new_indices.clear();
+
+  // sort the touched elements of the cell k based on their attr_sums
+  sort_by_attr_sum(pi_ptr->elements() + touched_start,
+      pi_ptr->elements() + end, workspace.attr_sums, &workspace.sort_buffer);
+  pi_ptr->refresh_positions(touched_start, end);
+
+  // in case an attr_sum type orders some sums below the untouched (empty)
+  // one, those have to go before the untouched vertices
+  if (touched_start > k) {
+    int *touched_ptr = pi_ptr->elements() + touched_start;
+    int *nonnegative_ptr = touched_ptr;
+    int *last_ptr = pi_ptr->elements() + end;
+
+    // the untouched attr_sums are stale, so search against the empty one
+    while (nonnegative_ptr < last_ptr) {
+      int *middle_ptr = nonnegative_ptr + (last_ptr - nonnegative_ptr) / 2;
+
+      if (workspace.attr_sums[*middle_ptr] < empty_attr_sum) {
+        nonnegative_ptr = middle_ptr + 1;
+      } else {
+        last_ptr = middle_ptr;
+      }
+    }
 
-  bool operator()(int u, int v) {
-    return (*attr_sums_ptr)[u] < (*attr_sums_ptr)[v];
-  }
-};
-
-template<typename attr_sum>
-static void clear_rest_of_cell(int k, int start, PartitionNest *pi_ptr, vector<
-    attr_sum> *attr_sums_ptr) {
-  for (int i = start; i < k + pi_ptr->cell_size(k); i++) {
-    int u = pi_ptr->elements()[i];
-    (*attr_sums_ptr)[u] = 0;
+    if (nonnegative_ptr != touched_ptr) {
+      std::rotate(pi_ptr->elements() + k, touched_ptr, nonnegative_ptr);
+      pi_ptr->refresh_positions(k, nonnegative_ptr - pi_ptr->elements());
+      touched_start = k;
+    }
   }
-}
-
-/*
- * Splits a single nontrivial cell based on the attr_sums.
- * Also cleans up its portion of the attr_sums.
- */
-template<typename graph_t>
-void Refiner<graph_t>::sort_and_split_index(int active_count, int k,
-    PartitionNest *pi_ptr, RefineTraceValue<graph_t> *trace_ptr,
-    vector<int> *active_indices_ptr, int *attr_sum_count_ptr, int *cmp_ptr) {
-  NbhrSumComparator<graph_t> cmp(&attr_sums);
-
-  // sort the elements of the cell k based on their attr_sums
-  std::sort(pi_ptr->elements() + k, pi_ptr->elements() + k + pi_ptr->cell_size(
-      k), cmp);
 
   // go cell by cell and record when the attr_sum changes
   int u = pi_ptr->elements()[k];
-  typename graph_t::attr_sum *prev_attr_sum_ptr = &attr_sums[u];
+  const typename graph_t::attr_sum *prev_attr_sum_ptr = &sown_attr_sum(u);
 
   // check the first cell
-  trace_attr_sum(active_count, k, *prev_attr_sum_ptr, *attr_sum_count_ptr,
-      trace_ptr, cmp_ptr);
+  trace_ptr->trace_attr_sum(active_count, k, *prev_attr_sum_ptr,
+      *attr_sum_count_ptr, cmp_ptr);
+  *attr_sum_count_ptr += 1;
 
   if (*cmp_ptr == 1) {
     return;
   }
 
-  // go through and add the splits
-  for (int i = k + 1; i < k + pi_ptr->cell_size(k); i++) {
+  // go through and add the splits, the untouched ones can't start a cell
+  // (unless the ones below the empty attr_sum were rotated in front of
+  // them, so the untouched ones are read by sown_attr_sum)
+  for (int i = std::max(k + 1, touched_start); i < end; i++) {
     u = pi_ptr->elements()[i];
 
     // if we encounter a different attr_sum
-    if (attr_sums[u] != *prev_attr_sum_ptr) {
+    if (sown_attr_sum(u) != *prev_attr_sum_ptr) {
       // enqueue the new index
       pi_ptr->enqueue_new_index(i);
-
-      // add this as an active index
-      active_indices_ptr->push_back(i);
+      workspace.new_indices.push_back(i);
 
       // update the pointer to the previous attr_sum
-      prev_attr_sum_ptr = &attr_sums[u];
+      prev_attr_sum_ptr = &sown_attr_sum(u);
 
       // see if the trace checks out
-      trace_attr_sum(active_count, i, *prev_attr_sum_ptr, *attr_sum_count_ptr,
-          trace_ptr, cmp_ptr);
+      trace_ptr->trace_attr_sum(active_count, i, *prev_attr_sum_ptr,
+          *attr_sum_count_ptr, cmp_ptr);
       *attr_sum_count_ptr += 1;
 
       if (*cmp_ptr == 1) {
@@ -316,17 +424,64 @@ void Refiner<graph_t>::sort_and_split_index(int active_count, int k,
   }
 
   pi_ptr->commit_pending_indices();
+
+  queue_fragments(k, end, active_indices_ptr);
+}
+
+/*
+ * Adds the fragments of the cell k ... end - 1 that was just split at
+ * new_indices as active indices (see set_skip_largest).
+ */
+template<typename graph_t, typename trace_t>
+void Refiner<graph_t, trace_t>::queue_fragments(int k, int end,
+    ActiveIndices *active_indices_ptr) {
+  const vector<int> &new_indices = workspace.new_indices;
+
+  if (new_indices.empty()) {
+    return;
+  }
+
+  // the fragment that is not queued
+  int skipped_index = k;
+
+  if (active_indices_ptr->contains(k)) {
+    // k is still queued, its cell just got smaller
+    active_indices_ptr->push(k, new_indices[0] - k);
+  } else if (skip_largest) {
+    int largest_size = new_indices[0] - k;
+
+    for (int t = 0; t < new_indices.size(); t++) {
+      int next = t + 1 < new_indices.size() ? new_indices[t + 1] : end;
+
+      if (next - new_indices[t] > largest_size) {
+        largest_size = next - new_indices[t];
+        skipped_index = new_indices[t];
+      }
+    }
+
+    if (skipped_index != k) {
+      active_indices_ptr->push(k, new_indices[0] - k);
+    }
+  }
+
+  for (int t = 0; t < new_indices.size(); t++) {
+    int next = t + 1 < new_indices.size() ? new_indices[t + 1] : end;
+
+    if (new_indices[t] != skipped_index) {
+      active_indices_ptr->push(new_indices[t], next - new_indices[t]);
+    }
+  }
 }
 
 // a helper for is_equitable
 template<typename graph_t>
 static void sow_vertex(map<int, typename graph_t::attr_sum> *attr_sums_ptr,
-    const graph_t &G, vertex_t u) {
+    const graph_t &G, typename graph_t::vertex u) {
   const typename graph_t::nbhr *nbhd = G.get_nbhd(u);
 
   for (int i = 0; i < G.get_nbhd_size(u); i++) {
-    vertex_t v = G.nbhr_vertex(nbhd[i]);
-    (*attr_sums_ptr)[v] += G.nbhr_attr(nbhd[i]);
+    typename graph_t::vertex v = graph_t::vertex_of(nbhd[i]);
+    (*attr_sums_ptr)[v] += graph_t::attr_of(nbhd[i]);
   }
 }
 
@@ -342,7 +497,7 @@ bool is_equitable(const graph_t &G, const PartitionNest &pi) {
     }
 
     vector<int> cell = pi[i];
-    vertex_t u = cell[0];
+    typename graph_t::vertex u = cell[0];
     map<int, typename graph_t::attr_sum> attr_sums;
 
     sow_vertex(&attr_sums, G, u);
@@ -350,7 +505,7 @@ bool is_equitable(const graph_t &G, const PartitionNest &pi) {
     // now verify that the other cells all sow the same
     for (int j = 1; j < pi.cell_size(i); j++) {
       map<int, typename graph_t::attr_sum> other_attr_sums;
-      vertex_t v = cell[j];
+      typename graph_t::vertex v = cell[j];
 
       sow_vertex(&other_attr_sums, G, v);
 
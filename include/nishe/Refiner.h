@@ -6,9 +6,13 @@
     Released under the Lesser General Public License v3.
 */
 
+#include <nishe/FlatRefineTrace.h>
 #include <nishe/Graph.h>
 #include <nishe/PartitionNest.h>
+#include <nishe/RefineTraceHash.h>
 #include <nishe/RefineTraceValue.h>
+#include <nishe/RefinerWorkspace.h>
+#include <nishe/VertexInvariant.h>
 
 #include <map>
 #include <vector>
@@ -29,36 +33,83 @@ namespace nishe {
  * The function also takes in and returns a trace of the refinement. The return
  * value is a comparison (-1, 0, or 1) between the trace of the current
  * refinement and the passed in trace.
+ *
+ * The trace is a RefineTraceValue (every attr_sum) by default, or a
+ * RefineTraceHash (a hash per active index) or FlatRefineTrace (every
+ * attr_sum in one buffer) given as trace_t.
  */
 
 template <typename graph_t>
 bool is_equitable(const graph_t &G, const PartitionNest &pi);
 
-template<typename graph_t>
+template<typename graph_t, typename trace_t = RefineTraceValue<graph_t> >
 class Refiner {
  public:
+  Refiner();
+
+  // only queue the fragments of a split cell other than the largest one
+  void set_skip_largest(bool skip_largest);
+
+  void set_order(ActiveIndices::Order order);
+
+  // splits the cells by a vertex invariant once refining can't
+  void set_invariant(VertexInvariant invariant, int arg = 0);
+
+  // the active index traced for the step that splits by the invariant
+  static const int INVARIANT_INDEX;
+
+  // the scratch buffers, to reserve() or trim() them
+  RefinerWorkspace<typename graph_t::attr_sum> &get_workspace() {
+    return workspace;
+  }
+
   int refine(const graph_t &G, PartitionNest *pi_ptr,
-      RefineTraceValue<graph_t> *trace_ptr, int initial_active_index = -1);
+      trace_t *trace_ptr, int initial_active_index = -1);
 
  private:
   int refine(const graph_t &G, PartitionNest *pi_ptr,
-      RefineTraceValue<graph_t> *trace_ptr, vector<int> *active_indices_ptr);
+      trace_t *trace_ptr, ActiveIndices *active_indices_ptr);
 
   void split_with_index(int active_index, int active_count, const graph_t &G,
-      PartitionNest *pi_ptr, RefineTraceValue<graph_t> *trace_ptr,
-      vector<int> *active_indices_ptr, int *cmp_ptr);
+      PartitionNest *pi_ptr, trace_t *trace_ptr,
+      ActiveIndices *active_indices_ptr, int *cmp_ptr);
 
-  void sort_and_split_indices(int active_count,
-      const set<int> &adjacent_indices, PartitionNest *pi_ptr,
-      RefineTraceValue<graph_t> *trace_ptr, vector<int> *active_indices_ptr,
+  void sort_and_split_indices(int active_count, PartitionNest *pi_ptr,
+      trace_t *trace_ptr, ActiveIndices *active_indices_ptr,
       int *cmp_ptr);
 
+  void split_with_invariant(int active_count, const graph_t &G,
+      PartitionNest *pi_ptr, trace_t *trace_ptr,
+      ActiveIndices *active_indices_ptr, int *cmp_ptr);
+
+  void group_touched_vertices(PartitionNest *pi_ptr);
+
   void sort_and_split_index(int active_count, int adjacent_index,
-      PartitionNest *pi_ptr, RefineTraceValue<graph_t> *trace_ptr,
-      vector<int> *active_indices_ptr, int *pNbhrSumCount, int *cmp_ptr);
+      int touched_count, PartitionNest *pi_ptr,
+      trace_t *trace_ptr, ActiveIndices *active_indices_ptr,
+      int *pNbhrSumCount, int *cmp_ptr);
+
+  void queue_fragments(int k, int end, ActiveIndices *active_indices_ptr);
+
+  // the attr_sum of u from the last sow (an untouched one is stale)
+  const typename graph_t::attr_sum &sown_attr_sum(int u) const {
+    return workspace.touched_vertices.contains(u) ? workspace.attr_sums[u] :
+        empty_attr_sum;
+  }
+
+  bool skip_largest;
+
+  VertexInvariant invariant;
+  int invariant_arg;
+
+  // the attr_sum of a vertex that wasn't sown to
+  typename graph_t::attr_sum empty_attr_sum;
+
+  // every scratch buffer, kept between refinements
+  RefinerWorkspace<typename graph_t::attr_sum> workspace;
 
-  // the place to sow nbhrs in
-  vector<typename graph_t::attr_sum> attr_sums;
+  // only allocated once an invariant is used
+  InvariantWorkspace invariant_workspace;
 };
 
 }  // namespace nishe
@@ -0,0 +1,107 @@
+#ifndef INCLUDE_NISHE_REFINERWORKSPACE_H_
+#define INCLUDE_NISHE_REFINERWORKSPACE_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/ActiveIndices.h>
+#include <nishe/AttrSumSort.h>
+#include <nishe/TouchedSet.h>
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace nishe {
+
+/*
+ * Every scratch buffer the refiner uses, kept from one refinement to the
+ * next (and from one graph to the next).
+ *
+ * The buffers only ever grow, to the largest graph refined so far (the high
+ * water mark), so once a refiner has seen its largest graph refining does
+ * not allocate. reserve() grows them ahead of time, and trim() gives the
+ * memory back after refining something much larger than usual.
+ *
+ * The one exception is an attr_sum type that allocates as it is sown into
+ * (MapDegreeSum), which still allocates while sowing.
+ */
+template<typename attr_sum>
+class RefinerWorkspace {
+ public:
+  RefinerWorkspace() :
+    vertex_capacity_(0) {
+  }
+
+  // makes room for graphs of up to n vertices
+  void reserve(int n) {
+    if (n <= vertex_capacity_) {
+      return;
+    }
+
+    attr_sums.resize(n);
+    touched_vertices.resize(n);
+    adjacent_indices.resize(n);
+    touched_counts.resize(n);
+    active_indices.resize(n);
+
+    new_indices.reserve(n);
+    sort_buffer.keyed.reserve(n);
+    sort_buffer.temp.reserve(n);
+
+    vertex_capacity_ = n;
+  }
+
+  // releases the memory of every buffer, keeping room for n vertices
+  void trim(int n = 0) {
+    std::vector<attr_sum>().swap(attr_sums);
+    touched_vertices.trim();
+    adjacent_indices.trim();
+    std::vector<int>().swap(touched_counts);
+    active_indices.trim();
+
+    std::vector<int>().swap(new_indices);
+    std::vector<KeyedVertex>().swap(sort_buffer.keyed);
+    std::vector<KeyedVertex>().swap(sort_buffer.temp);
+    std::vector<uint64_t>().swap(row);
+
+    vertex_capacity_ = 0;
+    reserve(n);
+  }
+
+  // the most vertices a graph can have without growing the buffers
+  int capacity() const {
+    return vertex_capacity_;
+  }
+
+  // the place to sow nbhrs in, only valid for the touched vertices
+  std::vector<attr_sum> attr_sums;
+
+  // the vertices the active cell was sown into, and the indices of them
+  TouchedSet touched_vertices;
+  TouchedSet adjacent_indices;
+
+  // how many vertices of each adjacent index were touched
+  std::vector<int> touched_counts;
+
+  // the indices waiting to be active indices
+  ActiveIndices active_indices;
+
+  // the indices a cell was just split at
+  std::vector<int> new_indices;
+
+  // scratch space for sorting the touched vertices of a cell
+  AttrSumSortBuffer sort_buffer;
+
+  // a cell as a row of bits, for graphs that sow by rows (DenseGraph)
+  std::vector<uint64_t> row;
+
+ private:
+  int vertex_capacity_;
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_REFINERWORKSPACE_H_
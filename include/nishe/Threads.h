@@ -0,0 +1,125 @@
+#ifndef INCLUDE_NISHE_THREADS_H_
+#define INCLUDE_NISHE_THREADS_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#ifdef HAS_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace nishe {
+
+/*
+ * What the parallel sorts and searches need from threads, behind
+ * HAS_PTHREAD (defined by the build when pthreads are found).
+ *
+ * Without it a Mutex does nothing, run_threads() makes each call in turn
+ * on the calling thread, and the atomics are plain reads and writes, so a
+ * single threaded build doesn't need a thread library at all.
+ */
+class Mutex {
+ public:
+  Mutex() {
+#ifdef HAS_PTHREAD
+    pthread_mutex_init(&mutex_, NULL);
+#endif
+  }
+
+  ~Mutex() {
+#ifdef HAS_PTHREAD
+    pthread_mutex_destroy(&mutex_);
+#endif
+  }
+
+  void lock() {
+#ifdef HAS_PTHREAD
+    pthread_mutex_lock(&mutex_);
+#endif
+  }
+
+  void unlock() {
+#ifdef HAS_PTHREAD
+    pthread_mutex_unlock(&mutex_);
+#endif
+  }
+
+ private:
+  // a mutex can't be copied
+  Mutex(const Mutex &);
+  Mutex &operator=(const Mutex &);
+
+#ifdef HAS_PTHREAD
+  pthread_mutex_t mutex_;
+#endif
+};
+
+// whether run_threads() really runs its calls at the same time
+inline bool has_threads() {
+#ifdef HAS_PTHREAD
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Calls f(&args[t]) for each t, args[0] on this thread and the rest on
+ * threads of their own, and waits for all of them. Fails with what_for in
+ * the message if a thread can't be created.
+ */
+template<typename arg_t>
+void run_threads(void *(*f)(void *), std::vector<arg_t> *args_ptr,
+    const char *what_for) {
+  std::vector<arg_t> &args = *args_ptr;
+
+#ifdef HAS_PTHREAD
+  std::vector<pthread_t> threads(args.size());
+
+  for (size_t t = 1; t < args.size(); t++) {
+    if (pthread_create(&threads[t], NULL, f, &args[t]) != 0) {
+      fprintf(stderr, "Error Error Examine: could not create a thread %s\n",
+          what_for);
+      exit(1);
+    }
+  }
+
+  f(&args[0]);
+
+  for (size_t t = 1; t < args.size(); t++) {
+    pthread_join(threads[t], NULL);
+  }
+#else
+  for (size_t t = 0; t < args.size(); t++) {
+    f(&args[t]);
+  }
+#endif
+}
+
+// *x_ptr = x, where every thread sees it
+inline void atomic_store(int *x_ptr, int x) {
+#ifdef HAS_PTHREAD
+  __sync_lock_test_and_set(x_ptr, x);
+#else
+  *x_ptr = x;
+#endif
+}
+
+// *x_ptr, as last stored by any thread
+inline int atomic_load(int *x_ptr) {
+#ifdef HAS_PTHREAD
+  return __sync_fetch_and_add(x_ptr, 0);
+#else
+  return *x_ptr;
+#endif
+}
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_THREADS_H_
@@ -0,0 +1,97 @@
+#ifndef INCLUDE_NISHE_TOUCHEDSET_H_
+#define INCLUDE_NISHE_TOUCHEDSET_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <vector>
+#include <algorithm>
+
+namespace nishe {
+
+/*
+ * A set of the integers 0 ... n - 1 touched while sowing a cell, used for
+ * both the vertices that were sown to and the indices containing them.
+ *
+ * A stamp per integer makes touch() O(1) with no allocation, and the
+ * distinct touched integers are kept in a list that can be sorted once
+ * after sowing (replacing a std::set<int> that took an insert per sown
+ * nbhr). An integer is touched when its stamp is the current epoch, so
+ * clear() just starts a new epoch; the stamps are only reset when the
+ * epoch wraps around.
+ *
+ * Since touch() says whether an integer is newly touched, the refiner uses
+ * it to reset the attr_sum of a vertex the first time it is sown to, so
+ * nothing has to be cleared after sowing either.
+ */
+class TouchedSet {
+ public:
+  TouchedSet() :
+    epoch_(1) {
+  }
+
+  // makes room for 0 ... n - 1, forgetting what was touched
+  void resize(int n) {
+    stamps_.assign(n, 0);
+    touched_.clear();
+    epoch_ = 1;
+  }
+
+  // releases the memory, leaving room for nothing
+  void trim() {
+    std::vector<unsigned int>().swap(stamps_);
+    std::vector<int>().swap(touched_);
+    epoch_ = 1;
+  }
+
+  // returns true if k wasn't touched yet
+  bool touch(int k) {
+    if (stamps_[k] == epoch_) {
+      return false;
+    }
+
+    stamps_[k] = epoch_;
+    touched_.push_back(k);
+
+    return true;
+  }
+
+  bool contains(int k) const {
+    return stamps_[k] == epoch_;
+  }
+
+  // puts the touched integers in increasing order
+  void sort() {
+    std::sort(touched_.begin(), touched_.end());
+  }
+
+  int size() const {
+    return touched_.size();
+  }
+
+  // the ith touched integer (in increasing order after sort())
+  int operator[](int i) const {
+    return touched_[i];
+  }
+
+  void clear() {
+    touched_.clear();
+    epoch_ += 1;
+
+    if (epoch_ == 0) {
+      std::fill(stamps_.begin(), stamps_.end(), 0);
+      epoch_ = 1;
+    }
+  }
+
+ private:
+  std::vector<unsigned int> stamps_;
+  std::vector<int> touched_;
+  unsigned int epoch_;
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_TOUCHEDSET_H_
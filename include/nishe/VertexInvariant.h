@@ -0,0 +1,390 @@
+#ifndef INCLUDE_NISHE_VERTEXINVARIANT_H_
+#define INCLUDE_NISHE_VERTEXINVARIANT_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Graph.h>
+#include <nishe/PartitionNest.h>
+#include <nishe/RefineTraceHash.h>
+#include <nishe/TouchedSet.h>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include <vector>
+
+namespace nishe {
+
+/*
+ * The vertex invariants the refiner can split cells by once refining
+ * can't split any more (see Refiner::set_invariant), for graphs like the
+ * regular and strongly regular ones that equitable refinement can't split
+ * at all.
+ *
+ * Each gives a vertex a value that only depends on the graph and the
+ * (ordered) partition, so splitting by it keeps the trace canonical:
+ *   TRIANGLES  the triangles u -> v -> w through u (with u -> w), each
+ *              weighted by the cells of v and w
+ *   DISTANCES  how many vertices of each cell are at each distance from u,
+ *              up to a distance of arg (0 for any distance)
+ *   CLIQUES    the cliques of arg vertices (3 or more, 4 by default)
+ *              containing u, each weighted by the cells of the others
+ *   QUADRUPLES for each triple v, w, x from u's cell, how many vertices are
+ *              nbhrs of an odd number of u, v, w, x, but only in the cells
+ *              of at most arg vertices (0 for any cell)
+ * The nbhds are taken as given (out-nbhds), a clique's vertices have to be
+ * nbhrs of each other both ways.
+ *
+ * They are computed for the vertices in nontrivial cells only, and cost far
+ * more than refining does (QUADRUPLES is O(c^4) for a cell of c vertices),
+ * which is why arg can restrict them.
+ */
+enum VertexInvariant {
+  NO_INVARIANT, TRIANGLES, DISTANCES, CLIQUES, QUADRUPLES
+};
+
+// the scratch buffers for computing vertex invariants
+class InvariantWorkspace {
+ public:
+  InvariantWorkspace() :
+    vertex_capacity_(0) {
+  }
+
+  // makes room for graphs of up to n vertices
+  void reserve(int n) {
+    if (n <= vertex_capacity_) {
+      return;
+    }
+
+    values.resize(n);
+    marks.resize(n);
+    distances.resize(n);
+    parities.resize(n);
+    queue.reserve(n);
+
+    vertex_capacity_ = n;
+  }
+
+  // the value of each vertex in a nontrivial cell
+  std::vector<vertex_t> values;
+
+  // the nontrivial indices to split
+  std::vector<int> indices;
+
+  TouchedSet marks;
+  std::vector<int> distances;
+  std::vector<int> queue;
+  std::vector<unsigned char> parities;
+
+  // the candidates for the next vertex of a clique, one list per vertex
+  std::vector<std::vector<int> > candidates;
+
+ private:
+  int vertex_capacity_;
+};
+
+static const uint64_t INVARIANT_SEED = 0x9e3779b97f4a7c15ULL;
+
+// a value per index for weighting what a vertex sees by cell
+inline uint64_t cell_weight(int k) {
+  return hash_mix(INVARIANT_SEED, k);
+}
+
+// what one structure seen from a vertex (x, y) adds to its invariant
+inline uint64_t invariant_term(uint64_t x, uint64_t y) {
+  return hash_mix(hash_mix(INVARIANT_SEED, x), y);
+}
+
+inline vertex_t fold_invariant(uint64_t h) {
+  return static_cast<vertex_t>(h ^ (h >> 32));
+}
+
+// returns true if v is a nbhr of u
+template<typename graph_t>
+bool has_nbhr(const graph_t &G, int u, int v) {
+  const typename graph_t::nbhr *nbhd = G.get_nbhd(u);
+  int nbhd_size = G.get_nbhd_size(u);
+
+  for (int i = 0; i < nbhd_size; i++) {
+    if (graph_t::vertex_of(nbhd[i]) == v) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template<typename graph_t>
+uint64_t triangles_invariant(const graph_t &G, const PartitionNest &pi,
+    int u, InvariantWorkspace *workspace_ptr) {
+  TouchedSet &marks = workspace_ptr->marks;
+  const typename graph_t::nbhr *nbhd = G.get_nbhd(u);
+  int nbhd_size = G.get_nbhd_size(u);
+  uint64_t h = 0;
+
+  marks.clear();
+
+  for (int i = 0; i < nbhd_size; i++) {
+    marks.touch(graph_t::vertex_of(nbhd[i]));
+  }
+
+  for (int i = 0; i < nbhd_size; i++) {
+    int v = graph_t::vertex_of(nbhd[i]);
+    const typename graph_t::nbhr *v_nbhd = G.get_nbhd(v);
+    int v_nbhd_size = G.get_nbhd_size(v);
+
+    if (v == u) {
+      continue;
+    }
+
+    for (int j = 0; j < v_nbhd_size; j++) {
+      int w = graph_t::vertex_of(v_nbhd[j]);
+
+      if (w != u && w != v && marks.contains(w)) {
+        h += invariant_term(cell_weight(pi.index_containing(v)),
+            cell_weight(pi.index_containing(w)));
+      }
+    }
+  }
+
+  return h;
+}
+
+template<typename graph_t>
+uint64_t distances_invariant(const graph_t &G, const PartitionNest &pi,
+    int u, int max_distance, InvariantWorkspace *workspace_ptr) {
+  TouchedSet &marks = workspace_ptr->marks;
+  std::vector<int> &distances = workspace_ptr->distances;
+  std::vector<int> &queue = workspace_ptr->queue;
+  uint64_t h = 0;
+
+  marks.clear();
+  queue.clear();
+
+  marks.touch(u);
+  distances[u] = 0;
+  queue.push_back(u);
+
+  // a breadth first search from u
+  for (int head = 0; head < queue.size(); head++) {
+    int v = queue[head];
+    const typename graph_t::nbhr *nbhd = G.get_nbhd(v);
+    int nbhd_size = G.get_nbhd_size(v);
+
+    if (max_distance > 0 && distances[v] == max_distance) {
+      continue;
+    }
+
+    for (int i = 0; i < nbhd_size; i++) {
+      int w = graph_t::vertex_of(nbhd[i]);
+
+      if (marks.touch(w)) {
+        distances[w] = distances[v] + 1;
+        queue.push_back(w);
+        h += invariant_term(distances[w], cell_weight(pi.index_containing(w)));
+      }
+    }
+  }
+
+  return h;
+}
+
+/*
+ * Adds the cliques made of the vertices chosen so far (weighing weight)
+ * and vertices of candidates[depth] to *h_ptr, where remaining more
+ * vertices are needed. Taking the candidates in list order counts each
+ * clique once.
+ */
+template<typename graph_t>
+void add_cliques(const graph_t &G, const PartitionNest &pi, int depth,
+    int remaining, uint64_t weight, uint64_t *h_ptr,
+    InvariantWorkspace *workspace_ptr) {
+  std::vector<std::vector<int> > &candidates = workspace_ptr->candidates;
+
+  for (int i = 0; i < candidates[depth].size(); i++) {
+    int v = candidates[depth][i];
+    uint64_t v_weight = weight + cell_weight(pi.index_containing(v));
+
+    if (remaining == 1) {
+      *h_ptr += invariant_term(0, v_weight);
+      continue;
+    }
+
+    TouchedSet &marks = workspace_ptr->marks;
+    const typename graph_t::nbhr *nbhd = G.get_nbhd(v);
+    int nbhd_size = G.get_nbhd_size(v);
+
+    marks.clear();
+
+    for (int j = 0; j < nbhd_size; j++) {
+      marks.touch(graph_t::vertex_of(nbhd[j]));
+    }
+
+    // the later candidates that are nbhrs of v both ways
+    candidates[depth + 1].clear();
+
+    for (int j = i + 1; j < candidates[depth].size(); j++) {
+      int w = candidates[depth][j];
+
+      if (marks.contains(w) && has_nbhr(G, w, v)) {
+        candidates[depth + 1].push_back(w);
+      }
+    }
+
+    add_cliques(G, pi, depth + 1, remaining - 1, v_weight, h_ptr,
+        workspace_ptr);
+  }
+}
+
+template<typename graph_t>
+uint64_t cliques_invariant(const graph_t &G, const PartitionNest &pi, int u,
+    int clique_size, InvariantWorkspace *workspace_ptr) {
+  std::vector<std::vector<int> > &candidates = workspace_ptr->candidates;
+  TouchedSet &marks = workspace_ptr->marks;
+  const typename graph_t::nbhr *nbhd = G.get_nbhd(u);
+  int nbhd_size = G.get_nbhd_size(u);
+  uint64_t h = 0;
+
+  if (candidates.size() < clique_size) {
+    candidates.resize(clique_size);
+  }
+
+  marks.clear();
+  candidates[0].clear();
+
+  // the distinct nbhrs of u both ways
+  for (int i = 0; i < nbhd_size; i++) {
+    int v = graph_t::vertex_of(nbhd[i]);
+
+    if (v != u && marks.touch(v) && has_nbhr(G, v, u)) {
+      candidates[0].push_back(v);
+    }
+  }
+
+  add_cliques(G, pi, 0, clique_size - 1, 0, &h, workspace_ptr);
+
+  return h;
+}
+
+// flips the parity of the nbhrs of u, keeping count of the odd ones
+template<typename graph_t>
+void flip_parities(const graph_t &G, int u,
+    std::vector<unsigned char> *parities_ptr, int *odd_count_ptr) {
+  std::vector<unsigned char> &parities = *parities_ptr;
+  const typename graph_t::nbhr *nbhd = G.get_nbhd(u);
+  int nbhd_size = G.get_nbhd_size(u);
+
+  for (int i = 0; i < nbhd_size; i++) {
+    int v = graph_t::vertex_of(nbhd[i]);
+
+    parities[v] ^= 1;
+    *odd_count_ptr += parities[v] ? 1 : -1;
+  }
+}
+
+template<typename graph_t>
+uint64_t quadruples_invariant(const graph_t &G, const PartitionNest &pi,
+    int u, InvariantWorkspace *workspace_ptr) {
+  std::vector<unsigned char> &parities = workspace_ptr->parities;
+  int k = pi.index_containing(u);
+  const int *cell = pi.elements() + k;
+  int cell_size = pi.cell_size(k);
+  int odd_count = 0;
+  uint64_t h = 0;
+
+  flip_parities(G, u, &parities, &odd_count);
+
+  for (int a = 0; a < cell_size; a++) {
+    if (cell[a] == u) {
+      continue;
+    }
+
+    flip_parities(G, cell[a], &parities, &odd_count);
+
+    for (int b = a + 1; b < cell_size; b++) {
+      if (cell[b] == u) {
+        continue;
+      }
+
+      flip_parities(G, cell[b], &parities, &odd_count);
+
+      for (int c = b + 1; c < cell_size; c++) {
+        if (cell[c] == u) {
+          continue;
+        }
+
+        flip_parities(G, cell[c], &parities, &odd_count);
+        h += invariant_term(0, odd_count);
+        flip_parities(G, cell[c], &parities, &odd_count);
+      }
+
+      flip_parities(G, cell[b], &parities, &odd_count);
+    }
+
+    flip_parities(G, cell[a], &parities, &odd_count);
+  }
+
+  // leave every parity even for the next vertex
+  flip_parities(G, u, &parities, &odd_count);
+
+  return h;
+}
+
+/*
+ * Sets workspace_ptr->values[u] to the vertex invariant of each u in a
+ * nontrivial cell of pi, and workspace_ptr->indices to the nontrivial
+ * indices.
+ */
+template<typename graph_t>
+void compute_vertex_invariant(const graph_t &G, const PartitionNest &pi,
+    VertexInvariant invariant, int arg, InvariantWorkspace *workspace_ptr) {
+  std::vector<int> &indices = workspace_ptr->indices;
+
+  if (invariant == CLIQUES && arg == 0) {
+    arg = 4;
+  }
+
+  if (invariant == CLIQUES && arg < 3) {
+    fprintf(stderr, "Error Error Examine: cliques of %d vertices is not an "
+        "invariant\n", arg);
+    exit(1);
+  }
+
+  workspace_ptr->reserve(G.vertex_count());
+  indices.clear();
+
+  for (int k = pi.first_nontrivial_index(); k != pi.terminal_index();
+       k = pi.next_nontrivial_index(k)) {
+    indices.push_back(k);
+  }
+
+  for (int t = 0; t < indices.size(); t++) {
+    int k = indices[t];
+
+    for (int i = k; i < k + pi.cell_size(k); i++) {
+      int u = pi.elements()[i];
+      uint64_t h = 0;
+
+      if (invariant == TRIANGLES) {
+        h = triangles_invariant(G, pi, u, workspace_ptr);
+      } else if (invariant == DISTANCES) {
+        h = distances_invariant(G, pi, u, arg, workspace_ptr);
+      } else if (invariant == CLIQUES) {
+        h = cliques_invariant(G, pi, u, arg, workspace_ptr);
+      } else if (invariant == QUADRUPLES &&
+          (arg == 0 || pi.cell_size(k) <= arg)) {
+        h = quadruples_invariant(G, pi, u, workspace_ptr);
+      }
+
+      workspace_ptr->values[u] = fold_invariant(h);
+    }
+  }
+}
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_VERTEXINVARIANT_H_
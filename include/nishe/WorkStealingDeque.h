@@ -0,0 +1,76 @@
+#ifndef INCLUDE_NISHE_WORKSTEALINGDEQUE_H_
+#define INCLUDE_NISHE_WORKSTEALINGDEQUE_H_
+
+/*
+  Copyright 2010 Greg Tener
+  Released under the Lesser General Public License v3.
+*/
+
+#include <nishe/Threads.h>
+
+#include <deque>
+
+namespace nishe {
+
+/*
+ * The tasks of one thread of a parallel search. The thread takes its own
+ * tasks from the bottom (the last pushed first), and a thread that has run
+ * out of tasks steals from the top of another thread's deque. Each deque
+ * has its own lock, so threads only contend for one while stealing from it.
+ */
+template<typename task_t>
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque() {
+  }
+
+  void push(const task_t &task) {
+    mutex_.lock();
+    tasks_.push_back(task);
+    mutex_.unlock();
+  }
+
+  // takes the bottom task, returns false if there are none
+  bool pop(task_t *task_ptr) {
+    mutex_.lock();
+
+    bool is_taken = !tasks_.empty();
+
+    if (is_taken) {
+      *task_ptr = tasks_.back();
+      tasks_.pop_back();
+    }
+
+    mutex_.unlock();
+
+    return is_taken;
+  }
+
+  // takes the top task, returns false if there are none
+  bool steal(task_t *task_ptr) {
+    mutex_.lock();
+
+    bool is_taken = !tasks_.empty();
+
+    if (is_taken) {
+      *task_ptr = tasks_.front();
+      tasks_.pop_front();
+    }
+
+    mutex_.unlock();
+
+    return is_taken;
+  }
+
+ private:
+  // a mutex can't be copied
+  WorkStealingDeque(const WorkStealingDeque &);
+  WorkStealingDeque &operator=(const WorkStealingDeque &);
+
+  Mutex mutex_;
+  std::deque<task_t> tasks_;
+};
+
+}  // namespace nishe
+
+#endif  // INCLUDE_NISHE_WORKSTEALINGDEQUE_H_
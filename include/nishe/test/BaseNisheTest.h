@@ -25,6 +25,7 @@ class BaseNisheTest : public ::testing::Test
      BasicGraph basic_graph;
      DirectedGraph directed_graph;
      IntegerWeightedGraph integer_weighted_graph;
+     PackedDirectedGraph packed_directed_graph;
      PartitionNest pi;
 
      template <typename graph_t>
@@ -0,0 +1,113 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/ArcIndex.h>
+
+#include <vector>
+
+using std::vector;
+
+namespace nishe {
+
+const int ArcIndex::NOT_FOUND = -1;
+
+// the smallest table allocated, it is kept at most half full
+static const size_t MIN_SLOT_COUNT = 16;
+
+// mixes the bits of an arc so that nearby arcs land in different slots
+static size_t hash_arc(size_t u, size_t v) {
+  unsigned long long h = u;
+
+  h = h * 0x9e3779b97f4a7c15ULL + v;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return static_cast<size_t>(h);
+}
+
+ArcIndex::ArcIndex() :
+  size_(0) {
+}
+
+size_t ArcIndex::slot_of(size_t u, size_t v) const {
+  // slots_.size() is always a power of two
+  size_t mask = slots_.size() - 1;
+  size_t i = hash_arc(u, v) & mask;
+
+  while (slots_[i].pos != NOT_FOUND &&
+         (slots_[i].u != u || slots_[i].v != v)) {
+    i = (i + 1) & mask;
+  }
+
+  return i;
+}
+
+int ArcIndex::find(size_t u, size_t v) const {
+  if (size_ == 0) {
+    return NOT_FOUND;
+  }
+
+  return slots_[slot_of(u, v)].pos;
+}
+
+void ArcIndex::insert(size_t u, size_t v, int pos) {
+  if (2 * (size_ + 1) > slots_.size()) {
+    rehash(slots_.size() < MIN_SLOT_COUNT ?
+        MIN_SLOT_COUNT : 2 * slots_.size());
+  }
+
+  Slot &slot = slots_[slot_of(u, v)];
+
+  if (slot.pos == NOT_FOUND) {
+    size_ += 1;
+  }
+
+  slot.u = u;
+  slot.v = v;
+  slot.pos = pos;
+}
+
+void ArcIndex::clear() {
+  vector<Slot>().swap(slots_);
+  size_ = 0;
+}
+
+void ArcIndex::reserve(size_t arc_count) {
+  size_t slot_count = MIN_SLOT_COUNT;
+
+  while (slot_count < 2 * arc_count) {
+    slot_count *= 2;
+  }
+
+  if (slot_count > slots_.size()) {
+    rehash(slot_count);
+  }
+}
+
+size_t ArcIndex::size() const {
+  return size_;
+}
+
+void ArcIndex::rehash(size_t slot_count) {
+  Slot empty;
+  empty.u = 0;
+  empty.v = 0;
+  empty.pos = NOT_FOUND;
+
+  vector<Slot> old_slots(slot_count, empty);
+  old_slots.swap(slots_);
+
+  // reinsert everything that was in the old table
+  for (size_t i = 0; i < old_slots.size(); i++) {
+    if (old_slots[i].pos != NOT_FOUND) {
+      slots_[slot_of(old_slots[i].u, old_slots[i].v)] = old_slots[i];
+    }
+  }
+}
+
+}  // namespace nishe
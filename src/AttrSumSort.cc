@@ -0,0 +1,172 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/AttrSumSort.h>
+
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+namespace nishe {
+
+// cells smaller than this are insertion sorted
+static const int INSERTION_CUTOFF = 24;
+
+// the radix sort goes 8 bits at a time
+static const int RADIX_BITS = 8;
+static const int RADIX = 1 << RADIX_BITS;
+
+// the number of bits needed to hold every key up to max_key
+static int key_bits(unsigned long long max_key) {
+  int bits = 0;
+
+  while (bits < 64 && (max_key >> bits) != 0) {
+    bits += 1;
+  }
+
+  return bits;
+}
+
+template<typename attr_sum>
+static void insertion_sort(int *first, int *last,
+    const vector<attr_sum> &attr_sums) {
+  for (int *i = first + 1; i < last; i++) {
+    int v = *i;
+    int *j = i;
+
+    for (; j > first && attr_sums[v] < attr_sums[*(j - 1)]; j--) {
+      *j = *(j - 1);
+    }
+
+    *j = v;
+  }
+}
+
+/*
+ * A stable LSD radix sort of the keyed vertices on the lowest bits bits of
+ * their keys, and then writes the vertices back to first. A pass where every
+ * key has the same digit is skipped, so the common case of keys under 256
+ * costs one counting pass.
+ */
+static void radix_sort(int *first, int bits, AttrSumSortBuffer *buffer_ptr) {
+  vector<KeyedVertex> &keyed = buffer_ptr->keyed;
+  vector<KeyedVertex> &temp = buffer_ptr->temp;
+  size_t size = keyed.size();
+
+  temp.resize(size);
+
+  for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+    size_t counts[RADIX];
+    std::fill(counts, counts + RADIX, 0);
+
+    for (size_t i = 0; i < size; i++) {
+      counts[(keyed[i].key >> shift) & (RADIX - 1)] += 1;
+    }
+
+    // if every key has the same digit this pass wouldn't move anything
+    if (counts[(keyed[0].key >> shift) & (RADIX - 1)] == size) {
+      continue;
+    }
+
+    // turn the counts into offsets
+    size_t offset = 0;
+
+    for (int digit = 0; digit < RADIX; digit++) {
+      size_t count = counts[digit];
+      counts[digit] = offset;
+      offset += count;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+      int digit = (keyed[i].key >> shift) & (RADIX - 1);
+      temp[counts[digit]] = keyed[i];
+      counts[digit] += 1;
+    }
+
+    keyed.swap(temp);
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    first[i] = keyed[i].v;
+  }
+}
+
+void sort_by_attr_sum(int *first, int *last, const vector<vertex_t> &attr_sums,
+    AttrSumSortBuffer *buffer_ptr) {
+  if (last - first < INSERTION_CUTOFF) {
+    insertion_sort(first, last, attr_sums);
+    return;
+  }
+
+  vector<KeyedVertex> &keyed = buffer_ptr->keyed;
+  unsigned long long max_key = 0;
+
+  keyed.resize(last - first);
+
+  for (int i = 0; i < last - first; i++) {
+    keyed[i].key = attr_sums[first[i]];
+    keyed[i].v = first[i];
+    max_key = std::max(max_key, keyed[i].key);
+  }
+
+  radix_sort(first, key_bits(max_key), buffer_ptr);
+}
+
+// key followed by the bits of part, where part fits in bits bits
+static unsigned long long append_bits(unsigned long long key,
+    unsigned long long part, int bits) {
+  // shifting by 64 is undefined, but then key has to be 0 anyways
+  return bits == 64 ? part : (key << bits) | part;
+}
+
+/*
+ * An InOutBoth is ordered by (in, out, both), so it packs into the key
+ * in << (out_bits + both_bits) | out << both_bits | both, each part only as
+ * wide as its largest value in the cell. The rare cell whose parts don't
+ * fit in 64 bits together is sorted by comparison.
+ */
+void sort_by_attr_sum(int *first, int *last,
+    const vector<InOutBoth> &attr_sums, AttrSumSortBuffer *buffer_ptr) {
+  if (last - first < INSERTION_CUTOFF) {
+    insertion_sort(first, last, attr_sums);
+    return;
+  }
+
+  unsigned long long max_weights[3] = {0, 0, 0};
+
+  for (int *i = first; i < last; i++) {
+    for (int j = 0; j < 3; j++) {
+      max_weights[j] = std::max<unsigned long long>(max_weights[j],
+          attr_sums[*i].weights[j]);
+    }
+  }
+
+  int out_bits = key_bits(max_weights[1]);
+  int both_bits = key_bits(max_weights[2]);
+  int bits = key_bits(max_weights[0]) + out_bits + both_bits;
+
+  if (bits > 64) {
+    std::sort(first, last, AttrSumLess<InOutBoth>(&attr_sums));
+    return;
+  }
+
+  vector<KeyedVertex> &keyed = buffer_ptr->keyed;
+
+  keyed.resize(last - first);
+
+  for (int i = 0; i < last - first; i++) {
+    const vertex_t *weights = attr_sums[first[i]].weights;
+    unsigned long long key = weights[0];
+
+    key = append_bits(key, weights[1], out_bits);
+    keyed[i].key = append_bits(key, weights[2], both_bits);
+    keyed[i].v = first[i];
+  }
+
+  radix_sort(first, bits, buffer_ptr);
+}
+
+}  // namespace nishe
@@ -23,7 +23,7 @@ bool BasicGraph::add_arc(vertex_t u, vertex_t v) {
 
   // if v is not in u's nbhd yet
   if (k == NOT_FOUND) {
-    vNbhds.at(u).push_back(v);
+    push_nbhr(u, v);
 
     return true;
   }
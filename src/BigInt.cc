@@ -0,0 +1,112 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/BigInt.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using std::string;
+
+namespace nishe {
+
+const unsigned int BigInt::DIGIT_BASE = 1000000000;
+
+BigInt::BigInt(unsigned long x) {
+  do {
+    digits_.push_back(x % DIGIT_BASE);
+    x /= DIGIT_BASE;
+  } while (x > 0);
+}
+
+BigInt &BigInt::operator*=(unsigned long x) {
+  // split x so each partial product fits in 64 bits
+  if (x >= DIGIT_BASE) {
+    unsigned long high = x / DIGIT_BASE;
+    BigInt shifted(*this);
+
+    shifted *= high;
+    shifted.digits_.insert(shifted.digits_.begin(), 0);
+    *this *= x % DIGIT_BASE;
+
+    // add shifted in
+    unsigned long long carry = 0;
+
+    if (digits_.size() < shifted.digits_.size()) {
+      digits_.resize(shifted.digits_.size(), 0);
+    }
+
+    for (size_t i = 0; i < digits_.size(); i++) {
+      carry += digits_[i];
+
+      if (i < shifted.digits_.size()) {
+        carry += shifted.digits_[i];
+      }
+
+      digits_[i] = carry % DIGIT_BASE;
+      carry /= DIGIT_BASE;
+    }
+
+    if (carry > 0) {
+      digits_.push_back(carry);
+    }
+  } else {
+    unsigned long long carry = 0;
+
+    for (size_t i = 0; i < digits_.size(); i++) {
+      carry += static_cast<unsigned long long>(digits_[i]) * x;
+      digits_[i] = carry % DIGIT_BASE;
+      carry /= DIGIT_BASE;
+    }
+
+    while (carry > 0) {
+      digits_.push_back(carry % DIGIT_BASE);
+      carry /= DIGIT_BASE;
+    }
+  }
+
+  // multiplying by 0 leaves leading 0s
+  while (digits_.size() > 1 && digits_.back() == 0) {
+    digits_.pop_back();
+  }
+
+  return *this;
+}
+
+int BigInt::cmp(const BigInt &b) const {
+  if (digits_.size() != b.digits_.size()) {
+    return digits_.size() < b.digits_.size() ? -1 : 1;
+  }
+
+  for (size_t i = digits_.size(); i > 0; i--) {
+    if (digits_[i - 1] != b.digits_[i - 1]) {
+      return digits_[i - 1] < b.digits_[i - 1] ? -1 : 1;
+    }
+  }
+
+  return 0;
+}
+
+string BigInt::to_string() const {
+  char buffer[16];
+  string s;
+
+  snprintf(buffer, sizeof(buffer), "%u", digits_.back());
+  s = buffer;
+
+  for (size_t i = digits_.size() - 1; i > 0; i--) {
+    snprintf(buffer, sizeof(buffer), "%09u", digits_[i - 1]);
+    s += buffer;
+  }
+
+  return s;
+}
+
+std::ostream &operator<<(std::ostream &out, const BigInt &x) {
+  return out << x.to_string();
+}
+
+}  // namespace nishe
@@ -13,55 +13,9 @@ using std::make_pair;
 
 namespace nishe {
 
-const size_t DirectedGraph::IN = 0;
-const size_t DirectedGraph::OUT = 1;
-const size_t DirectedGraph::BOTH = 2;
-
-InOutBoth &InOutBoth::operator+=(int k) {
-  weights[k] += 1;
-
-  return *this;
-}
-
-InOutBoth &InOutBoth::operator=(int k) {
-  weights[DirectedGraph::IN] = k;
-  weights[DirectedGraph::OUT] = k;
-  weights[DirectedGraph::BOTH] = k;
-
-  return *this;
-}
-
-bool InOutBoth::operator<(const InOutBoth &a) const {
-  for (int i = 0; i < sizeof(weights) / sizeof(*weights); i++) {
-    if (weights[i] < a.weights[i]) {
-      return true;
-    } else if (weights[i] > a.weights[i]) {
-      return false;
-    }
-  }
-
-  return false;
-}
-
-bool InOutBoth::operator!=(const InOutBoth &a) const {
-  for (int i = 0; i < sizeof(weights) / sizeof(*weights); i++) {
-    if (weights[i] != a.weights[i]) {
-      return true;
-    }
-  }
-
-  return false;
-}
-
-bool InOutBoth::operator==(const InOutBoth &a) const {
-  for (int i = 0; i < sizeof(weights) / sizeof(*weights); i++) {
-    if (weights[i] != a.weights[i]) {
-      return false;
-    }
-  }
-
-  return true;
-}
+const unsigned int DirectedGraph::IN = 0;
+const unsigned int DirectedGraph::OUT = 1;
+const unsigned int DirectedGraph::BOTH = 2;
 
 bool DirectedGraph::add_arc(vertex_t u, vertex_t v) {
   add_vertex(std::max(u, v));
@@ -71,9 +25,9 @@ bool DirectedGraph::add_arc(vertex_t u, vertex_t v) {
   // we have a new edge
   if (k == NOT_FOUND) {
     // add the out edge
-    vNbhds.at(u).push_back(make_pair(v, DirectedGraph::OUT));
+    push_nbhr(u, make_pair(v, DirectedGraph::OUT));
     // add the in edge
-    vNbhds.at(v).push_back(make_pair(u, DirectedGraph::IN));
+    push_nbhr(v, make_pair(u, DirectedGraph::IN));
   } else {  // this edge is already here
     // if the edge is not an incoming one, we can't add it
     if (vNbhds.at(u).at(k).second != DirectedGraph::IN) {
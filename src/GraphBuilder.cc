@@ -0,0 +1,377 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/GraphBuilder.h>
+#include <nishe/Threads.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+using std::vector;
+using std::make_pair;
+
+namespace nishe {
+
+typedef GraphBuilder::KeyedArc KeyedArc;
+
+// the radix sort goes 8 bits at a time
+static const int RADIX_BITS = 8;
+static const int RADIX = 1 << RADIX_BITS;
+
+// fewer arcs than this are sorted by one thread
+static const size_t PARALLEL_CUTOFF = 1 << 15;
+
+/*
+ * One thread's share of a radix sort pass: the arcs [begin, end) of src.
+ * The first phase counts the digits, the second scatters the arcs into dst
+ * starting at the offsets computed from every thread's counts.
+ */
+struct RadixTask {
+  const KeyedArc *src;
+  KeyedArc *dst;
+  size_t begin;
+  size_t end;
+  int shift;
+  size_t counts[RADIX];
+};
+
+static void *count_digits(void *arg) {
+  RadixTask *task = static_cast<RadixTask *>(arg);
+
+  std::fill(task->counts, task->counts + RADIX, 0);
+
+  for (size_t i = task->begin; i < task->end; i++) {
+    task->counts[(task->src[i].key >> task->shift) & (RADIX - 1)] += 1;
+  }
+
+  return NULL;
+}
+
+static void *scatter_digits(void *arg) {
+  RadixTask *task = static_cast<RadixTask *>(arg);
+
+  // the counts have been turned into starting offsets by now
+  for (size_t i = task->begin; i < task->end; i++) {
+    int digit = (task->src[i].key >> task->shift) & (RADIX - 1);
+    task->dst[task->counts[digit]] = task->src[i];
+    task->counts[digit] += 1;
+  }
+
+  return NULL;
+}
+
+/*
+ * A stable LSD radix sort of the arcs on the lowest key_bits bits of their
+ * keys. Each pass is split into thread_count contiguous chunks, and since
+ * chunk t's arcs go after chunk t - 1's arcs with the same digit the sort
+ * stays stable.
+ */
+static void radix_sort(vector<KeyedArc> *arcs_ptr, vector<KeyedArc> *temp_ptr,
+    int key_bits, int thread_count) {
+  size_t size = arcs_ptr->size();
+
+  // there is nothing to sort (or to take the address of)
+  if (size == 0) {
+    return;
+  }
+
+  if (size < PARALLEL_CUTOFF) {
+    thread_count = 1;
+  }
+
+  temp_ptr->resize(size);
+
+  vector<RadixTask> tasks(thread_count);
+
+  for (int shift = 0; shift < key_bits; shift += RADIX_BITS) {
+    for (int t = 0; t < thread_count; t++) {
+      tasks[t].src = &(*arcs_ptr)[0];
+      tasks[t].dst = &(*temp_ptr)[0];
+      tasks[t].begin = size * t / thread_count;
+      tasks[t].end = size * (t + 1) / thread_count;
+      tasks[t].shift = shift;
+    }
+
+    run_threads(count_digits, &tasks, "to sort arcs");
+
+    // turn the counts into offsets, digit by digit and then thread by thread
+    size_t offset = 0;
+    bool one_digit = false;
+
+    for (int digit = 0; digit < RADIX; digit++) {
+      size_t digit_start = offset;
+
+      for (int t = 0; t < thread_count; t++) {
+        size_t count = tasks[t].counts[digit];
+        tasks[t].counts[digit] = offset;
+        offset += count;
+      }
+
+      if (offset - digit_start == size) {
+        one_digit = true;
+      }
+    }
+
+    // if every arc has the same digit this pass wouldn't move anything
+    if (one_digit) {
+      continue;
+    }
+
+    run_threads(scatter_digits, &tasks, "to sort arcs");
+    arcs_ptr->swap(*temp_ptr);
+  }
+}
+
+// without threads the chunks of a sort would only take turns
+GraphBuilder::GraphBuilder(int thread_count) :
+  thread_count_(has_threads() ? std::max(thread_count, 1) : 1),
+      vertex_count_(0), vertex_bits_(0) {
+}
+
+void GraphBuilder::add(const vertex_t *us, const vertex_t *vs,
+    const int *weights, size_t count, bool reverse) {
+  for (size_t i = 0; i < count; i++) {
+    int weight = weights == NULL ? 0 : weights[i];
+
+    add_vertex(std::max(us[i], vs[i]));
+
+    us_.push_back(us[i]);
+    vs_.push_back(vs[i]);
+    weights_.push_back(weight);
+
+    // the reverse goes right after the arc, as add_edge adds it, so the
+    // first weight kept for each arc is the same
+    if (reverse) {
+      us_.push_back(vs[i]);
+      vs_.push_back(us[i]);
+      weights_.push_back(weight);
+    }
+  }
+}
+
+void GraphBuilder::add_arcs(const vertex_t *us, const vertex_t *vs,
+    size_t count) {
+  add(us, vs, NULL, count, false);
+}
+
+void GraphBuilder::add_edges(const vertex_t *us, const vertex_t *vs,
+    size_t count) {
+  add(us, vs, NULL, count, true);
+}
+
+void GraphBuilder::add_weighted_arcs(const vertex_t *us, const vertex_t *vs,
+    const int *weights, size_t count) {
+  add(us, vs, weights, count, false);
+}
+
+void GraphBuilder::add_weighted_edges(const vertex_t *us,
+    const vertex_t *vs, const int *weights, size_t count) {
+  add(us, vs, weights, count, true);
+}
+
+void GraphBuilder::add_vertex(vertex_t u) {
+  if (vertex_count_ < u + 1) {
+    vertex_count_ = u + 1;
+  }
+}
+
+void GraphBuilder::clear() {
+  vertex_count_ = 0;
+  us_.clear();
+  vs_.clear();
+  weights_.clear();
+  arcs_.clear();
+}
+
+size_t GraphBuilder::arc_count() const {
+  return us_.size();
+}
+
+int GraphBuilder::vertex_count() const {
+  return vertex_count_;
+}
+
+vertex_t GraphBuilder::key_u(unsigned long long key) const {
+  return key >> vertex_bits_;
+}
+
+vertex_t GraphBuilder::key_v(unsigned long long key) const {
+  return key & ((1ULL << vertex_bits_) - 1);
+}
+
+unsigned long long GraphBuilder::make_key(vertex_t u, vertex_t v) const {
+  return (static_cast<unsigned long long>(u) << vertex_bits_) | v;
+}
+
+int GraphBuilder::sort_arcs() {
+  int n = vertex_count_;
+
+  // only sort on as many bits as there are in the largest (u, v)
+  vertex_bits_ = 1;
+
+  while ((1ULL << vertex_bits_) < vertex_count_) {
+    vertex_bits_ += 1;
+  }
+
+  arcs_.resize(us_.size());
+
+  for (size_t i = 0; i < us_.size(); i++) {
+    arcs_[i].key = make_key(us_[i], vs_[i]);
+    arcs_[i].weight = weights_[i];
+  }
+
+  radix_sort(&arcs_, &arcs_temp_, 2 * vertex_bits_, thread_count_);
+
+  // the sort is stable, so keeping the first of each key keeps the
+  // first arc that was added
+  size_t unique_count = 0;
+
+  for (size_t i = 0; i < arcs_.size(); i++) {
+    if (unique_count == 0 || arcs_[i].key != arcs_[unique_count - 1].key) {
+      arcs_[unique_count] = arcs_[i];
+      unique_count += 1;
+    }
+  }
+
+  arcs_.resize(unique_count);
+
+  us_.clear();
+  vs_.clear();
+  weights_.clear();
+  vertex_count_ = 0;
+
+  return n;
+}
+
+// counts how many nbhrs each u will get so the nbhds are allocated once
+template<typename graph_t>
+static void reserve_nbhds(const vector<size_t> &degrees,
+    vector<vector<typename graph_t::nbhr> > *nbhds_ptr) {
+  nbhds_ptr->resize(degrees.size());
+
+  for (size_t u = 0; u < degrees.size(); u++) {
+    (*nbhds_ptr)[u].reserve(degrees[u]);
+  }
+}
+
+void GraphBuilder::finalize(BasicGraph *G_ptr) {
+  int n = sort_arcs();
+
+  G_ptr->clear();
+
+  vector<size_t> degrees(n);
+
+  for (size_t i = 0; i < arcs_.size(); i++) {
+    degrees[key_u(arcs_[i].key)] += 1;
+  }
+
+  reserve_nbhds<BasicGraph>(degrees, &G_ptr->vNbhds);
+
+  for (size_t i = 0; i < arcs_.size(); i++) {
+    G_ptr->vNbhds[key_u(arcs_[i].key)].push_back(key_v(arcs_[i].key));
+  }
+
+  arcs_.clear();
+  G_ptr->reindex();
+}
+
+void GraphBuilder::finalize(IntegerWeightedGraph *G_ptr) {
+  int n = sort_arcs();
+
+  G_ptr->clear();
+
+  vector<size_t> degrees(n);
+
+  for (size_t i = 0; i < arcs_.size(); i++) {
+    degrees[key_u(arcs_[i].key)] += 1;
+  }
+
+  reserve_nbhds<IntegerWeightedGraph>(degrees, &G_ptr->vNbhds);
+
+  for (size_t i = 0; i < arcs_.size(); i++) {
+    G_ptr->vNbhds[key_u(arcs_[i].key)].push_back(
+        make_pair(key_v(arcs_[i].key), arcs_[i].weight));
+  }
+
+  arcs_.clear();
+  G_ptr->reindex();
+}
+
+static bool key_less(const KeyedArc &a, const KeyedArc &b) {
+  return a.key < b.key;
+}
+
+/*
+ * Each arc (u, v) puts v in u's nbhd as OUT and u in v's nbhd as IN, unless
+ * (v, u) is an arc as well, in which case the pair becomes one BOTH nbhr in
+ * each nbhd. A loop (u, u) is both an OUT and an IN nbhr of u, just as
+ * DirectedGraph::add_arc makes it.
+ */
+template<typename graph_t>
+void GraphBuilder::finalize_directed(graph_t *G_ptr) {
+  int n = sort_arcs();
+
+  G_ptr->clear();
+
+  // whether the reverse of each arc is present
+  vector<bool> symmetric(arcs_.size());
+  vector<size_t> degrees(n);
+
+  for (size_t i = 0; i < arcs_.size(); i++) {
+    vertex_t u = key_u(arcs_[i].key);
+    vertex_t v = key_v(arcs_[i].key);
+
+    KeyedArc reverse;
+    reverse.key = make_key(v, u);
+
+    symmetric[i] = u != v &&
+        std::binary_search(arcs_.begin(), arcs_.end(), reverse, key_less);
+
+    // a symmetric pair is counted once from each end
+    degrees[u] += 1;
+
+    if (!symmetric[i]) {
+      degrees[v] += 1;
+    }
+  }
+
+  reserve_nbhds<graph_t>(degrees, &G_ptr->vNbhds);
+
+  for (size_t i = 0; i < arcs_.size(); i++) {
+    vertex_t u = key_u(arcs_[i].key);
+    vertex_t v = key_v(arcs_[i].key);
+
+    if (symmetric[i]) {
+      G_ptr->vNbhds[u].push_back(graph_t::make_nbhr(v, graph_t::BOTH));
+    } else {
+      G_ptr->vNbhds[u].push_back(graph_t::make_nbhr(v, graph_t::OUT));
+      G_ptr->vNbhds[v].push_back(graph_t::make_nbhr(u, graph_t::IN));
+    }
+  }
+
+  arcs_.clear();
+  G_ptr->reindex();
+}
+
+void GraphBuilder::finalize(DirectedGraph *G_ptr) {
+  finalize_directed(G_ptr);
+}
+
+void GraphBuilder::finalize(PackedDirectedGraph *G_ptr) {
+  // the vertices are 0 ... vertex_count_ - 1
+  if (vertex_count_ > static_cast<size_t>(PackedDirectedGraph::max_vertex())
+      + 1) {
+    fprintf(stderr, "Error Error Examine: %s\n",
+        "vertex is too large for a packed nbhr");
+    exit(1);
+  }
+
+  finalize_directed(G_ptr);
+}
+
+}  // namespace nishe
@@ -4,11 +4,15 @@
  */
 
 #include <nishe/GraphIO-inl.h>
+#include <nishe/GraphBuilder.h>
 
 #include <exception>
 #include <stdexcept>
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <climits>
+#include <vector>
 
 namespace nishe {
 
@@ -30,7 +34,9 @@ static bool add_edge(BasicGraph *G_ptr, vertex_t u, string token) {
   return G_ptr->add_edge(u, v);
 }
 
-static bool add_arc(DirectedGraph *G_ptr, vertex_t u, string token) {
+// for both DirectedGraph and PackedDirectedGraph
+template<typename graph_t>
+static bool add_arc(graph_t *G_ptr, vertex_t u, string token) {
   std::stringstream ss(token);
   vertex_t v = 0;
 
@@ -85,24 +91,36 @@ void output_nbhr_directed_graph(ostream &out, const DirectedGraph::nbhr &nbhr) {
   }
 }
 
+void output_nbhr_packed_directed_graph(ostream &out,
+    const PackedDirectedGraph::nbhr &nbhr) {
+  if (PackedDirectedGraph::attr_of(nbhr) == PackedDirectedGraph::OUT) {
+    out << PackedDirectedGraph::vertex_of(nbhr);
+  }
+}
+
 void output_nbhr_integer_weighted_graph(ostream &out,
-    const DirectedGraph::nbhr &nbhr) {
+    const IntegerWeightedGraph::nbhr &nbhr) {
   out << nbhr.first << "," << nbhr.second;
 }
 
 bool GraphIO::input_list_ascii(istream &in, BasicGraph *G_ptr,
     PartitionNest *pPi) {
-  GraphIO::input_list_ascii(in, G_ptr, pPi, add_edge);
+  return GraphIO::input_list_ascii(in, G_ptr, pPi, add_edge);
 }
 
 bool GraphIO::input_list_ascii(istream &in, DirectedGraph *G_ptr,
     PartitionNest *pPi) {
-  GraphIO::input_list_ascii(in, G_ptr, pPi, add_arc);
+  return GraphIO::input_list_ascii(in, G_ptr, pPi, add_arc);
 }
 
 bool GraphIO::input_list_ascii(istream &in, IntegerWeightedGraph *G_ptr,
     PartitionNest *pPi) {
-  GraphIO::input_list_ascii(in, G_ptr, pPi, add_weighted_edge);
+  return GraphIO::input_list_ascii(in, G_ptr, pPi, add_weighted_edge);
+}
+
+bool GraphIO::input_list_ascii(istream &in, PackedDirectedGraph *G_ptr,
+    PartitionNest *pPi) {
+  return GraphIO::input_list_ascii(in, G_ptr, pPi, add_arc);
 }
 
 void GraphIO::output_list_ascii(ostream &out, const BasicGraph &G) {
@@ -117,6 +135,133 @@ void GraphIO::output_list_ascii(ostream &out, const IntegerWeightedGraph &G) {
   GraphIO::output_list_ascii(out, G, output_nbhr_integer_weighted_graph);
 }
 
+void GraphIO::output_list_ascii(ostream &out, const PackedDirectedGraph &G) {
+  GraphIO::output_list_ascii(out, G, output_nbhr_packed_directed_graph);
+}
+
+// reads a 1-based vertex of a vertex_count vertex dimacs graph
+static vertex_t input_dimacs_vertex(istream &in, size_t vertex_count,
+    const char *line_type) {
+  long long v = 0;
+
+  in >> v;
+
+  if (in.fail() || v < 1 || v > static_cast<long long>(vertex_count)) {
+    stringstream ss;
+    ss << "expected a vertex from 1 to " << vertex_count << " on an ";
+    ss << line_type << " line";
+    fail(ss.str());
+  }
+
+  return v - 1;
+}
+
+/*
+ * Reads a dimacs graph's edges and colors, returns false at eof.
+ * Reads straight from the stream one token at a time, with no stringstream
+ * per line, and collects the edges so the graph is built all at once.
+ */
+static bool read_dimacs(istream &in, vector<vertex_t> *us_ptr,
+    vector<vertex_t> *vs_ptr, vector<unsigned int> *colors_ptr) {
+  string line;
+  char line_type = 0;
+  size_t vertex_count = 0;
+  size_t edge_count = 0;
+  bool found_problem = false;
+
+  us_ptr->clear();
+  vs_ptr->clear();
+  colors_ptr->clear();
+
+  while (in >> line_type) {
+    if (line_type == 'c') {
+      getline(in, line);
+    } else if (line_type == 'p') {
+      string format;
+
+      in >> format >> vertex_count >> edge_count;
+
+      if (in.fail() || found_problem) {
+        fail("expected one \"p edge <vertex_count> <edge_count>\" line");
+      }
+
+      found_problem = true;
+      colors_ptr->assign(vertex_count, 0);
+      us_ptr->reserve(edge_count);
+      vs_ptr->reserve(edge_count);
+    } else if (!found_problem) {
+      fail("expected a \"p\" line before any \"n\" or \"e\" lines");
+    } else if (line_type == 'n') {
+      vertex_t v = input_dimacs_vertex(in, vertex_count, "n");
+      long long color = 0;
+
+      in >> color;
+
+      if (in.fail() || color < 0 || color > UINT_MAX) {
+        fail("expected an unsigned int color on an n line");
+      }
+
+      (*colors_ptr)[v] = color;
+    } else if (line_type == 'e') {
+      us_ptr->push_back(input_dimacs_vertex(in, vertex_count, "e"));
+      vs_ptr->push_back(input_dimacs_vertex(in, vertex_count, "e"));
+    } else {
+      string err = "unknown dimacs line type: ";
+      err += line_type;
+      fail(err);
+    }
+  }
+
+  return found_problem;
+}
+
+// builds the graph of the edges (or arcs) read and its colored partition
+template<typename graph_t>
+static bool input_dimacs(istream &in, graph_t *G_ptr, PartitionNest *pi_ptr,
+    bool symmetric) {
+  vector<vertex_t> us;
+  vector<vertex_t> vs;
+  vector<unsigned int> colors;
+
+  if (!read_dimacs(in, &us, &vs, &colors)) {
+    return false;
+  }
+
+  GraphBuilder builder;
+
+  if (colors.size() > 0) {
+    builder.add_vertex(colors.size() - 1);
+  }
+
+  if (symmetric) {
+    builder.add_edges(us.empty() ? NULL : &us[0], vs.empty() ? NULL : &vs[0],
+        us.size());
+  } else {
+    builder.add_arcs(us.empty() ? NULL : &us[0], vs.empty() ? NULL : &vs[0],
+        us.size());
+  }
+
+  builder.finalize(G_ptr);
+  pi_ptr->colored(colors.size(), colors.empty() ? NULL : &colors[0]);
+
+  return true;
+}
+
+bool GraphIO::input_dimacs(istream &in, BasicGraph *G_ptr,
+    PartitionNest *pi_ptr) {
+  return nishe::input_dimacs(in, G_ptr, pi_ptr, true);
+}
+
+bool GraphIO::input_dimacs(istream &in, DirectedGraph *G_ptr,
+    PartitionNest *pi_ptr) {
+  return nishe::input_dimacs(in, G_ptr, pi_ptr, false);
+}
+
+bool GraphIO::input_dimacs(istream &in, PackedDirectedGraph *G_ptr,
+    PartitionNest *pi_ptr) {
+  return nishe::input_dimacs(in, G_ptr, pi_ptr, false);
+}
+
 // ignore the arc type and just add the edge
 static void directed2basic(vertex_t u, vertex_t v,
     const DirectedGraph::attr &attr, BasicGraph *G_ptr) {
@@ -138,6 +283,237 @@ void GraphIO::convert(const DirectedGraph &directed,
   convert(directed, integer_weighted_ptr, directed2integer_weighted);
 }
 
+// each arc is seen from both of its ends, so only add it from the tail
+static void directed2packed(vertex_t u, vertex_t v,
+    const DirectedGraph::attr &attr, PackedDirectedGraph *G_ptr) {
+  if (attr != DirectedGraph::IN) {
+    G_ptr->add_arc(u, v);
+  }
+}
+
+void GraphIO::convert(const DirectedGraph &directed,
+    PackedDirectedGraph *packed_ptr) {
+  convert(directed, packed_ptr, directed2packed);
+}
+
+static void packed2directed(vertex_t u, vertex_t v,
+    const PackedDirectedGraph::attr &attr, DirectedGraph *G_ptr) {
+  if (attr != PackedDirectedGraph::IN) {
+    G_ptr->add_arc(u, v);
+  }
+}
+
+void GraphIO::convert(const PackedDirectedGraph &packed,
+    DirectedGraph *directed_ptr) {
+  convert(packed, directed_ptr, packed2directed);
+}
+
+const uint64_t GraphIO::BINARY_MAGIC = 0x4e49534845435352ULL;  // NISHECSR
+const uint32_t GraphIO::BINARY_VERSION = 1;
+const uint32_t GraphIO::BINARY_HAS_PARTITION = 1;
+
+uint32_t GraphIO::binary_type(const BasicGraph *) {
+  return 0;
+}
+
+uint32_t GraphIO::binary_type(const DirectedGraph *) {
+  return 1;
+}
+
+uint32_t GraphIO::binary_type(const IntegerWeightedGraph *) {
+  return 2;
+}
+
+uint32_t GraphIO::binary_type(const PackedDirectedGraph *) {
+  return 3;
+}
+
+bool GraphIO::is_valid_attr(const BasicGraph *, BasicGraph::attr attr) {
+  return true;
+}
+
+// the arc type indexes the (in, out, both) degree sums
+bool GraphIO::is_valid_attr(const DirectedGraph *, DirectedGraph::attr attr) {
+  return attr == DirectedGraph::IN || attr == DirectedGraph::OUT
+      || attr == DirectedGraph::BOTH;
+}
+
+bool GraphIO::is_valid_attr(const IntegerWeightedGraph *,
+    IntegerWeightedGraph::attr attr) {
+  return true;
+}
+
+bool GraphIO::is_valid_attr(const PackedDirectedGraph *,
+    PackedDirectedGraph::attr attr) {
+  return attr == PackedDirectedGraph::IN || attr == PackedDirectedGraph::OUT
+      || attr == PackedDirectedGraph::BOTH;
+}
+
+void GraphIO::output_binary_header(ostream &out, uint32_t graph_type,
+    uint32_t nbhr_bytes, int vertex_count, uint64_t arc_count,
+    const PartitionNest *pi_ptr) {
+  BinaryHeader header;
+
+  memset(&header, 0, sizeof(header));
+  header.magic = BINARY_MAGIC;
+  header.version = BINARY_VERSION;
+  header.graph_type = graph_type;
+  header.vertex_bytes = sizeof(vertex_t);
+  header.nbhr_bytes = nbhr_bytes;
+  header.vertex_count = vertex_count;
+  header.arc_count = arc_count;
+
+  if (pi_ptr != NULL) {
+    if (pi_ptr->size() != vertex_count) {
+      stringstream ss;
+      ss << "partition size is ";
+      ss << pi_ptr->size() << " but the graph has ";
+      ss << vertex_count << " vertices";
+      fail(ss.str());
+    }
+
+    header.flags |= BINARY_HAS_PARTITION;
+
+    // every index but 0
+    for (int k = 0; k < pi_ptr->terminal_index(); k = pi_ptr->next_index(k)) {
+      header.index_count += 1;
+    }
+
+    header.index_count -= vertex_count > 0;
+  }
+
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void GraphIO::output_binary_partition(ostream &out, const PartitionNest &pi) {
+  vector<int32_t> indices;
+
+  for (int k = pi.next_index(0); k < pi.terminal_index();
+      k = pi.next_index(k)) {
+    indices.push_back(k);
+  }
+
+  if (pi.size() == 0) {
+    return;
+  }
+
+  out.write(reinterpret_cast<const char *>(pi.elements()),
+      pi.size() * sizeof(int32_t));
+
+  if (!indices.empty()) {
+    out.write(reinterpret_cast<const char *>(&indices[0]),
+        indices.size() * sizeof(int32_t));
+  }
+}
+
+size_t GraphIO::binary_nbhrs_start(const BinaryHeader &header) {
+  return sizeof(BinaryHeader) + (header.vertex_count + 1) * sizeof(uint64_t);
+}
+
+size_t GraphIO::binary_partition_start(const BinaryHeader &header) {
+  size_t nbhrs_size = header.arc_count * header.nbhr_bytes;
+
+  return binary_nbhrs_start(header) + (nbhrs_size + 7) / 8 * 8;
+}
+
+const BinaryHeader *GraphIO::check_binary(const MappedFile &mapping,
+    uint32_t graph_type, uint32_t nbhr_bytes) {
+  if (mapping.size() < sizeof(BinaryHeader)) {
+    fail("binary graph file is too short for its header");
+  }
+
+  const BinaryHeader *header =
+      reinterpret_cast<const BinaryHeader *>(mapping.data());
+
+  if (header->magic != BINARY_MAGIC) {
+    fail("not a binary graph file (or it has the wrong byte order)");
+  }
+
+  if (header->version != BINARY_VERSION) {
+    fail("unsupported binary graph file version");
+  }
+
+  if (header->graph_type != graph_type || header->nbhr_bytes != nbhr_bytes ||
+      header->vertex_bytes != sizeof(vertex_t)) {
+    fail("binary graph file was written for a different graph type");
+  }
+
+  // vertices are ints once read
+  if (header->vertex_count > static_cast<uint64_t>(INT_MAX)) {
+    fail("binary graph file has more vertices than an int can count");
+  }
+
+  size_t expected_size = binary_partition_start(*header);
+
+  if (header->flags & BINARY_HAS_PARTITION) {
+    expected_size += (header->vertex_count + header->index_count)
+        * sizeof(int32_t);
+  }
+
+  if (mapping.size() != expected_size) {
+    stringstream ss;
+    ss << "binary graph file is " << mapping.size() << " bytes but ";
+    ss << expected_size << " were expected";
+    fail(ss.str());
+  }
+
+  // the nbhrs are checked by input_binary, which knows how to decode them
+  const uint64_t *offsets =
+      reinterpret_cast<const uint64_t *>(mapping.data() + sizeof(BinaryHeader));
+
+  for (uint64_t u = 0; u < header->vertex_count; u++) {
+    if (offsets[u] > offsets[u + 1]) {
+      fail("binary graph file offsets are not increasing");
+    }
+  }
+
+  if (offsets[0] != 0 || offsets[header->vertex_count] != header->arc_count) {
+    fail("binary graph file offsets do not cover the nbhrs");
+  }
+
+  return header;
+}
+
+void GraphIO::input_binary_partition(const MappedFile &mapping,
+    PartitionNest *pi_ptr) {
+  const BinaryHeader &header =
+      *reinterpret_cast<const BinaryHeader *>(mapping.data());
+  int n = header.vertex_count;
+
+  pi_ptr->unit(n);
+
+  if (!(header.flags & BINARY_HAS_PARTITION)) {
+    return;
+  }
+
+  const int32_t *elements = reinterpret_cast<const int32_t *>(
+      mapping.data() + binary_partition_start(header));
+  const int32_t *indices = elements + n;
+
+  vector<bool> seen(n);
+
+  for (int i = 0; i < n; i++) {
+    if (elements[i] < 0 || elements[i] >= n || seen[elements[i]]) {
+      fail("binary graph file partition is not a permutation");
+    }
+
+    seen[elements[i]] = true;
+    pi_ptr->elements()[i] = elements[i];
+  }
+
+  pi_ptr->refresh_positions(0, n);
+
+  for (uint64_t i = 0; i < header.index_count; i++) {
+    if (indices[i] <= (i == 0 ? 0 : indices[i - 1]) || indices[i] >= n) {
+      fail("binary graph file partition indices are not increasing");
+    }
+
+    pi_ptr->enqueue_new_index(indices[i]);
+  }
+
+  pi_ptr->commit_pending_indices();
+}
+
 void GraphIO::path(BasicGraph *G_ptr, int n) {
   G_ptr->clear();
 
@@ -29,7 +29,7 @@ bool IntegerWeightedGraph::add_weighted_arc(vertex_t u, vertex_t v,
   // if there is no edge going to v
   if (k == NOT_FOUND) {
     // add the uv nbhr
-    vNbhds.at(u).push_back(make_pair(v, weight));
+    push_nbhr(u, make_pair(v, weight));
 
     return true;
   }
@@ -0,0 +1,177 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/MappedFile.h>
+
+#ifdef _WIN32
+#include <windows.h>  // NOLINT
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+namespace nishe {
+
+#ifdef _WIN32
+
+// maps the whole file at path read only, false if it can't or it's empty
+static bool map_file(const std::string &path, void **addr_ptr,
+    size_t *size_ptr) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+      NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  CloseHandle(file);
+
+  if (mapping == NULL) {
+    return false;
+  }
+
+  void *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+  // the view stays valid after the handles are closed
+  CloseHandle(mapping);
+
+  if (addr == NULL) {
+    return false;
+  }
+
+  *addr_ptr = addr;
+  *size_ptr = static_cast<size_t>(file_size.QuadPart);
+
+  return true;
+}
+
+static void unmap_file(void *addr, size_t size) {
+  UnmapViewOfFile(addr);
+}
+
+#else
+
+// maps the whole file at path read only, false if it can't or it's empty
+static bool map_file(const std::string &path, void **addr_ptr,
+    size_t *size_ptr) {
+  int fd = open(path.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+
+  *addr_ptr = addr;
+  *size_ptr = st.st_size;
+
+  return true;
+}
+
+static void unmap_file(void *addr, size_t size) {
+  munmap(addr, size);
+}
+
+#endif
+
+MappedFile::MappedFile() :
+  mapping_(NULL) {
+}
+
+MappedFile::MappedFile(const MappedFile &f) :
+  mapping_(f.mapping_) {
+  if (mapping_ != NULL) {
+    mapping_->refs += 1;
+  }
+}
+
+MappedFile::~MappedFile() {
+  unmap();
+}
+
+MappedFile &MappedFile::operator=(const MappedFile &f) {
+  if (f.mapping_ != NULL) {
+    f.mapping_->refs += 1;
+  }
+
+  unmap();
+  mapping_ = f.mapping_;
+
+  return *this;
+}
+
+bool MappedFile::map(std::string path) {
+  unmap();
+
+  void *addr;
+  size_t size;
+
+  if (!map_file(path, &addr, &size)) {
+    return false;
+  }
+
+  mapping_ = new Mapping;
+  mapping_->addr = addr;
+  mapping_->size = size;
+  mapping_->refs = 1;
+
+  return true;
+}
+
+void MappedFile::unmap() {
+  if (mapping_ == NULL) {
+    return;
+  }
+
+  mapping_->refs -= 1;
+
+  if (mapping_->refs == 0) {
+    unmap_file(mapping_->addr, mapping_->size);
+    delete mapping_;
+  }
+
+  mapping_ = NULL;
+}
+
+bool MappedFile::is_mapped() const {
+  return mapping_ != NULL;
+}
+
+const char *MappedFile::data() const {
+  return mapping_ == NULL ? NULL : static_cast<const char *>(mapping_->addr);
+}
+
+size_t MappedFile::size() const {
+  return mapping_ == NULL ? 0 : mapping_->size;
+}
+
+}  // namespace nishe
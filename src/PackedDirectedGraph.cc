@@ -0,0 +1,52 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/PackedDirectedGraph.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+namespace nishe {
+
+// the same arc types as DirectedGraph so the two convert by copying attrs
+const unsigned int PackedDirectedGraph::IN = 0;
+const unsigned int PackedDirectedGraph::OUT = 1;
+const unsigned int PackedDirectedGraph::BOTH = 2;
+
+bool PackedDirectedGraph::add_arc(vertex_t u, vertex_t v) {
+  if (std::max(u, v) > max_vertex()) {
+    fprintf(stderr, "Error Error Examine: %s\n",
+        "vertex is too large for a packed nbhr");
+    exit(1);
+  }
+
+  add_vertex(std::max(u, v));
+
+  int k = find_nbhr(u, v);
+
+  // we have a new edge
+  if (k == NOT_FOUND) {
+    // add the out edge
+    push_nbhr(u, make_nbhr(v, PackedDirectedGraph::OUT));
+    // add the in edge
+    push_nbhr(v, make_nbhr(u, PackedDirectedGraph::IN));
+  } else {  // this edge is already here
+    // if the edge is not an incoming one, we can't add it
+    if (attr_of(vNbhds.at(u).at(k)) != PackedDirectedGraph::IN) {
+      return false;
+    }
+
+    // set u's to be both
+    vNbhds.at(u).at(k) = make_nbhr(v, PackedDirectedGraph::BOTH);
+
+    // find where u is in v's neighborhood and set it to (both) as well
+    vNbhds.at(v).at(find_nbhr(v, u)) = make_nbhr(u, PackedDirectedGraph::BOTH);
+  }
+
+  return true;
+}
+
+}  // namespace nishe
@@ -36,14 +36,26 @@ int PartitionNest::unit(int n) {
   }
 
   // set the elements to the integers from 0 to n - 1
-  // the index containing to 0 for all
+  // all in the cell with id 0 starting at 0
   // and the cell sizes to n for the 0th index
   elements_.resize(n);
-  index_containing_.resize(n);
+  cell_ids_.resize(n);
+  positions_.resize(n);
 
   for (i = 0; i < n; i++) {
     elements_[i] = i;
-    index_containing_[i] = 0;
+    cell_ids_[i] = 0;
+    positions_[i] = i;
+  }
+
+  cell_starts_.resize(n);
+  cell_starts_[0] = 0;
+
+  // the other ids, the smallest on top
+  free_cell_ids_.clear();
+
+  for (i = n - 1; i > 0; i--) {
+    free_cell_ids_.push_back(i);
   }
 
   cell_sizes_.resize(n);
@@ -67,6 +79,54 @@ int PartitionNest::unit(int n) {
   return n;
 }
 
+/*
+ * A counting sort of the elements by color one byte at a time (a stable LSD
+ * radix sort), only on the bytes any color actually uses, so this is O(n)
+ * with no comparisons. Each place the color changes becomes an index.
+ */
+int PartitionNest::colored(int n, const unsigned int *colors) {
+  unit(n);
+
+  if (n == 0) {
+    return 0;
+  }
+
+  unsigned int max_color = *std::max_element(colors, colors + n);
+  vector<int> sorted(n);
+
+  for (int shift = 0; shift < 32 && (max_color >> shift) > 0; shift += 8) {
+    int counts[256 + 1] = {0};
+
+    for (int i = 0; i < n; i++) {
+      counts[((colors[elements_[i]] >> shift) & 255) + 1] += 1;
+    }
+
+    for (int digit = 0; digit < 256; digit++) {
+      counts[digit + 1] += counts[digit];
+    }
+
+    for (int i = 0; i < n; i++) {
+      int digit = (colors[elements_[i]] >> shift) & 255;
+      sorted[counts[digit]] = elements_[i];
+      counts[digit] += 1;
+    }
+
+    elements_.swap(sorted);
+  }
+
+  refresh_positions(0, n);
+
+  for (int i = 1; i < n; i++) {
+    if (colors[elements_[i]] != colors[elements_[i - 1]]) {
+      enqueue_new_index(i);
+    }
+  }
+
+  commit_pending_indices();
+
+  return n;
+}
+
 int PartitionNest::size() const {
   return elements_.size();
 }
@@ -84,19 +144,33 @@ int PartitionNest::cell_size(int k) const {
 }
 
 int PartitionNest::index_containing(int u) const {
-  return index_containing_[u];
+  return cell_starts_[cell_ids_[u]];
+}
+
+int PartitionNest::position_of(int u) const {
+  return positions_[u];
+}
+
+void PartitionNest::refresh_positions(int start, int end) {
+  for (int i = start; i < end; i++) {
+    positions_[elements_[i]] = i;
+  }
 }
 
 int *PartitionNest::elements() {
   return &elements_[0];
 }
 
+const int *PartitionNest::elements() const {
+  return &elements_[0];
+}
+
 int PartitionNest::level() {
   return new_indices_at_level_.size() - 1;
 }
 
 bool PartitionNest::is_index(int k) const {
-  return index_containing_[elements_[k]] == k;
+  return index_containing(elements_[k]) == k;
 }
 
 bool PartitionNest::is_nontrivial_index(int k) const {
@@ -188,56 +262,45 @@ bool PartitionNest::enqueue_new_index(int k) {
 }
 
 void PartitionNest::commit_pending_indices() {
-  int i = 0;
-
-  while (i < new_index_queue_.size()) {
-    int k_next = 0;  // the next place to add a split
+  // each split leaves both parts labeled, so the next one finds its cell
+  for (size_t i = 0; i < new_index_queue_.size(); i++) {
     int k = new_index_queue_[i];
-    int u = elements_[k];
-
-    // the cell containing the run of splits
-    int first = index_containing_[u];
-    int first_size = cell_sizes_[first];
-
-    // a moving starting point of the current cell we're adding a split to
-    int start = first;
-
-    while (i + 1 < new_index_queue_.size()) {
-      k_next = new_index_queue_[i + 1];
-      u = elements_[k_next];
-
-      // check that this index is in the same cell as all of the others
-      if (index_containing_[u] != first) {
-        break;
-      }
 
-      commit_index(start, k, k_next);
-
-      start = k;
-      k = k_next;
-      i += 1;
+    if (!is_index(k)) {
+      commit_index(index_containing(elements_[k]), k);
     }
-
-    k_next = first + first_size;
-    commit_index(start, k, k_next);
-
-    i += 1;
   }
 
   new_index_queue_.clear();
 }
 
-void PartitionNest::commit_index(int nStart, int k, int k_next) {
-  int i = 0;
-  int nStartSize = 0;
+// gives the elements at start ... end - 1 the cell id
+void PartitionNest::relabel_cell(int start, int end, int id) {
+  for (int i = start; i < end; i++) {
+    cell_ids_[elements_[i]] = id;
+  }
+}
 
-  // set the elements to be members of the new cell
-  for (i = k; i < k_next; i++) {
-    index_containing_[elements_[i]] = k;
+// splits the cell at nStart into nStart ... k - 1 and k ... its end
+void PartitionNest::commit_index(int nStart, int k) {
+  int nStartSize = cell_sizes_[nStart];
+  int nEnd = nStart + nStartSize;
+  int id = cell_ids_[elements_[nStart]];
+  int new_id = free_cell_ids_.back();
+
+  free_cell_ids_.pop_back();
+
+  // the smaller part takes the new id
+  if (k - nStart >= nEnd - k) {
+    relabel_cell(k, nEnd, new_id);
+    cell_starts_[new_id] = k;
+  } else {
+    relabel_cell(nStart, k, new_id);
+    cell_starts_[new_id] = nStart;
+    cell_starts_[id] = k;
   }
 
   // update the cell sizes
-  nStartSize = cell_sizes_[nStart];
   cell_sizes_[nStart] = k - nStart;
   cell_sizes_[k] = nStartSize - cell_sizes_[nStart];
 
@@ -292,23 +355,18 @@ void PartitionNest::insert_index(int nStart, int k, int nStartSize) {
 
 int PartitionNest::advance_level() {
   new_indices_at_level_.push_back(0);
+
+  return level();
 }
 
 int PartitionNest::recover_level(int m) {
   int split_count = 0;
-  set<int> start_indices;
-  vector<int> cell_end;
-  vector<int> original_sizes;
   int k = 0;
   int k_size = 0;
-  int k_temp = 0;
   int nStart = 0;
   int nStartSize = 0;
-  int nEnd = 0;
   int i = 0;
 
-  // the cell ends are 0
-  cell_end.resize(size());
   new_index_queue_.clear();
 
   while (level() > m) {
@@ -328,35 +386,23 @@ int PartitionNest::recover_level(int m) {
     // update the nontrivial linked list
     erase_index(nStart, k, nStartSize, k_size);
 
+    // the splits after this one are undone, so the two cells are whole
+    // again, and the smaller one takes the larger one's id
+    int id = cell_ids_[elements_[nStart]];
+    int k_id = cell_ids_[elements_[k]];
+
+    if (nStartSize >= k_size) {
+      relabel_cell(k, k + k_size, id);
+      free_cell_ids_.push_back(k_id);
+    } else {
+      relabel_cell(nStart, k, k_id);
+      cell_starts_[k_id] = nStart;
+      free_cell_ids_.push_back(id);
+    }
+
     // update the sizes (k is removed, nStart is enlarged)
     cell_sizes_[k] = 0;
     cell_sizes_[nStart] += k_size;
-
-    // manage keeping track of where nStart ends
-    nEnd = cell_end[k];
-
-    // if k has no end yet, end where k ended
-    if (nEnd == 0) {
-      nEnd = k + k_size - 1;
-    } else {  // otherwise k isn't a start anymore
-      cell_end[k] = 0;
-      start_indices.erase(k);
-    }
-
-    start_indices.insert(nStart);
-    cell_end[nStart] = nEnd;
-  }
-
-  // run through cStartIndices and update index containing
-  set<int>::iterator it;
-
-  for (it = start_indices.begin(); it != start_indices.end(); it++) {
-    nStart = (*it);
-    nEnd = cell_end[nStart];
-
-    for (i = nStart; i <= nEnd; i++) {
-      index_containing_[elements_[i]] = nStart;
-    }
   }
 
   return level();
@@ -380,22 +426,16 @@ bool PartitionNest::breakout(int u) {
     exit(1);
   }
 
-  int i = k;
+  int i = position_of(u);
 
-  for (; i < k + cell_size(k); i++) {
-    if (anElements[i] == u) {
-      break;
-    }
-  }
-
-  // u should always be found, if not foul play is involved
-  if (i == k + cell_size(k)) {
+  // u should always be in its cell, if not foul play is involved
+  if (i < k || i >= k + cell_size(k) || anElements[i] != u) {
     fprintf(stderr, "Error Error Examine: %d %s %d of %s\n", u,
         "was not found at index", k, str().c_str());
     exit(1);
   }
 
-  std::swap(anElements[k], anElements[i]);
+  swap_elements(k, i);
 
   add_index(k + 1);
 
@@ -590,6 +630,8 @@ istream &operator>>(istream &in, PartitionNest &pi) {
     pi.elements()[i] = elements[i];
   }
 
+  pi.refresh_positions(0, elements.size());
+
   for (int i = 0; i < indices.size(); i++) {
     pi.enqueue_new_index(indices[i]);
   }
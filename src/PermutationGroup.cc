@@ -0,0 +1,280 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/PermutationGroup.h>
+
+#include <vector>
+
+using std::vector;
+
+namespace nishe {
+
+const int PermutationGroup::NOT_IN_ORBIT = -1;
+const int PermutationGroup::BASE_POINT = -2;
+
+// random elements sifting in a row before the chain is taken as complete
+static const int DEFAULT_COMPLETION_ROUNDS = 30;
+
+// the fewest elements product replacement walks with
+static const int MIN_RANDOM_ELEMENTS = 10;
+
+// the steps taken to mix in a new generator before sampling
+static const int RANDOM_WARMUP_STEPS = 20;
+
+// where the random walk starts, so a group is built the same way each time
+static const unsigned int RANDOM_SEED = 12345;
+
+PermutationGroup::PermutationGroup() :
+  degree_(0), completion_rounds_(DEFAULT_COMPLETION_ROUNDS),
+      random_seed_(RANDOM_SEED) {
+}
+
+void PermutationGroup::reset(int n) {
+  reset(n, vector<int>());
+}
+
+void PermutationGroup::reset(int n, const vector<int> &base_prefix) {
+  degree_ = n;
+
+  base_.clear();
+  generators_.clear();
+  inverses_.clear();
+  generator_levels_.clear();
+  schreier_vectors_.clear();
+  basic_orbits_.clear();
+  random_elements_.clear();
+
+  random_product_.resize(n);
+  random_seed_ = RANDOM_SEED;
+
+  for (int u = 0; u < n; u++) {
+    random_product_[u] = u;
+  }
+
+  for (size_t i = 0; i < base_prefix.size(); i++) {
+    add_base_point(base_prefix[i]);
+  }
+}
+
+void PermutationGroup::add_base_point(int u) {
+  int i = base_.size();
+
+  base_.push_back(u);
+  schreier_vectors_.push_back(vector<int>(degree_, NOT_IN_ORBIT));
+  basic_orbits_.push_back(vector<int>(1, u));
+  schreier_vectors_[i][u] = BASE_POINT;
+
+  update_basic_orbit(i);
+}
+
+// extends the basic orbit of b_i by the strong generators fixing b_0 ...
+// b_(i - 1)
+void PermutationGroup::update_basic_orbit(int i) {
+  vector<int> &schreier_vector = schreier_vectors_[i];
+  vector<int> &orbit = basic_orbits_[i];
+
+  for (size_t j = 0; j < orbit.size(); j++) {
+    int u = orbit[j];
+
+    for (size_t g = 0; g < generators_.size(); g++) {
+      if (generator_levels_[g] < i) {
+        continue;
+      }
+
+      int v = generators_[g][u];
+
+      if (schreier_vector[v] == NOT_IN_ORBIT) {
+        schreier_vector[v] = g;
+        orbit.push_back(v);
+      }
+    }
+  }
+}
+
+void PermutationGroup::add_strong_generator(const vector<int> &x, int level) {
+  vector<int> inverse(degree_);
+
+  for (int u = 0; u < degree_; u++) {
+    inverse[x[u]] = u;
+  }
+
+  generators_.push_back(x);
+  inverses_.push_back(inverse);
+  generator_levels_.push_back(level);
+
+  // x is in the stabilizer of b_0 ... b_(i - 1) for each i up to its level
+  for (int i = 0; i <= level; i++) {
+    update_basic_orbit(i);
+  }
+
+  // and in the random walk, which is padded to its fewest elements
+  random_elements_.push_back(x);
+
+  while (random_elements_.size() < MIN_RANDOM_ELEMENTS) {
+    random_elements_.push_back(generators_[
+        random_elements_.size() % generators_.size()]);
+  }
+
+  vector<int> discard;
+
+  for (int step = 0; step < RANDOM_WARMUP_STEPS; step++) {
+    random_element(&discard);
+  }
+}
+
+/*
+ * Divides *x_ptr by the coset representatives of the chain, level by level,
+ * returning the level it stopped at: the first one whose basic orbit
+ * doesn't have the image of the base point, or base().size() if it got
+ * through (and *x_ptr is the identity if x was in the group).
+ */
+int PermutationGroup::sift(vector<int> *x_ptr) const {
+  vector<int> &x = *x_ptr;
+
+  for (size_t i = 0; i < base_.size(); i++) {
+    const vector<int> &schreier_vector = schreier_vectors_[i];
+    int p = x[base_[i]];
+
+    if (schreier_vector[p] == NOT_IN_ORBIT) {
+      return i;
+    }
+
+    // follow p back to b_i, applying the inverse generators to x
+    while (schreier_vector[p] != BASE_POINT) {
+      const vector<int> &inverse = inverses_[schreier_vector[p]];
+
+      for (int u = 0; u < degree_; u++) {
+        x[u] = inverse[x[u]];
+      }
+
+      p = inverse[p];
+    }
+  }
+
+  return base_.size();
+}
+
+// the smallest point x moves, degree() for the identity
+int PermutationGroup::first_moved_point(const vector<int> &x) const {
+  int u = 0;
+
+  while (u < degree_ && x[u] == u) {
+    u++;
+  }
+
+  return u;
+}
+
+bool PermutationGroup::is_identity(const vector<int> &x) const {
+  return first_moved_point(x) == degree_;
+}
+
+unsigned int PermutationGroup::next_random() {
+  random_seed_ = random_seed_ * 1103515245 + 12345;
+
+  return random_seed_ >> 8;
+}
+
+/*
+ * The next element of the product replacement walk: a random element of the
+ * walk is multiplied by another one, and the running product by it.
+ */
+void PermutationGroup::random_element(vector<int> *x_ptr) {
+  int count = random_elements_.size();
+  int i = next_random() % count;
+  int j = next_random() % (count - 1);
+
+  if (j >= i) {
+    j += 1;
+  }
+
+  vector<int> &a = random_elements_[i];
+  const vector<int> &b = random_elements_[j];
+
+  scratch_.resize(degree_);
+
+  if (next_random() & 1) {
+    // a becomes a, then b
+    for (int u = 0; u < degree_; u++) {
+      scratch_[u] = b[a[u]];
+    }
+  } else {
+    for (int u = 0; u < degree_; u++) {
+      scratch_[u] = a[b[u]];
+    }
+  }
+
+  a.swap(scratch_);
+
+  for (int u = 0; u < degree_; u++) {
+    random_product_[u] = a[random_product_[u]];
+  }
+
+  *x_ptr = random_product_;
+}
+
+/*
+ * Sifts random elements until completion_rounds_ in a row sift to the
+ * identity, adding the ones that don't as strong generators.
+ */
+void PermutationGroup::complete() {
+  vector<int> x;
+  int rounds = 0;
+
+  while (rounds < completion_rounds_) {
+    random_element(&x);
+
+    int level = sift(&x);
+
+    if (level == static_cast<int>(base_.size()) && is_identity(x)) {
+      rounds += 1;
+      continue;
+    }
+
+    if (level == static_cast<int>(base_.size())) {
+      // x fixes the whole base, so a point it moves joins the base
+      add_base_point(first_moved_point(x));
+    }
+
+    add_strong_generator(x, level);
+    rounds = 0;
+  }
+}
+
+bool PermutationGroup::add_generator(const int *x) {
+  vector<int> h(x, x + degree_);
+  int level = sift(&h);
+
+  if (level == static_cast<int>(base_.size())) {
+    if (is_identity(h)) {
+      return false;
+    }
+
+    add_base_point(first_moved_point(h));
+  }
+
+  add_strong_generator(h, level);
+  complete();
+
+  return true;
+}
+
+bool PermutationGroup::contains(const int *x) const {
+  vector<int> h(x, x + degree_);
+
+  return sift(&h) == static_cast<int>(base_.size()) && is_identity(h);
+}
+
+BigInt PermutationGroup::order() const {
+  BigInt order(1);
+
+  for (size_t i = 0; i < basic_orbits_.size(); i++) {
+    order *= basic_orbits_[i].size();
+  }
+
+  return order;
+}
+
+}  // namespace nishe
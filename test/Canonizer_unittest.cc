@@ -0,0 +1,359 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/test/BaseNisheTest.h>
+
+#include <nishe/Canonizer-inl.h>
+#include <nishe/Graph-inl.h>
+#include <nishe/Graphs.h>
+#include <nishe/GraphIO-inl.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using std::vector;
+
+namespace nishe {
+
+class CanonizerTest: public BaseNisheTest {
+ public:
+  // a random permutation of 0 ... n - 1
+  vector<int> random_permutation(int n, unsigned int *x_ptr) {
+    vector<int> perm(n);
+
+    for (int i = 0; i < n; i++) {
+      perm[i] = i;
+    }
+
+    for (int i = n - 1; i > 0; i--) {
+      *x_ptr = *x_ptr * 1103515245 + 12345;
+      std::swap(perm[i], perm[(*x_ptr >> 8) % (i + 1)]);
+    }
+
+    return perm;
+  }
+
+  // H is G with each vertex u relabeled perm[u]
+  void permute(const BasicGraph &G, const vector<int> &perm, BasicGraph *H_ptr) {
+    H_ptr->clear();
+    H_ptr->add_vertex(G.vertex_count() - 1);
+
+    for (int u = 0; u < G.vertex_count(); u++) {
+      for (int i = 0; i < G.get_nbhd_size(u); i++) {
+        H_ptr->add_arc(perm[u], perm[G.get_nbhd(u)[i]]);
+      }
+    }
+  }
+
+  // G's canonical graph, checking that it is G relabeled by the labeling
+  CompressedGraph<BasicGraph> canonical_graph(const BasicGraph &G,
+      const PartitionNest &pi) {
+    Canonizer<BasicGraph> canonizer;
+    CompressedGraph<BasicGraph> relabeled;
+
+    canonizer.canonize(G, pi);
+    relabeled.assign_relabeled(G, &canonizer.labeling()[0]);
+    EXPECT_EQ(0, relabeled.cmp(canonizer.canonical_graph()) );
+
+    return canonizer.canonical_graph();
+  }
+
+  CompressedGraph<BasicGraph> canonical_graph(const BasicGraph &G) {
+    PartitionNest unit_pi;
+
+    unit_pi.unit(G.vertex_count());
+
+    return canonical_graph(G, unit_pi);
+  }
+
+  void petersen(BasicGraph *G_ptr) {
+    G_ptr->clear();
+
+    for (int i = 0; i < 5; i++) {
+      G_ptr->add_edge(i, (i + 1) % 5);
+      G_ptr->add_edge(i, i + 5);
+      G_ptr->add_edge(i + 5, (i + 2) % 5 + 5);
+    }
+  }
+};
+
+TEST_F(CanonizerTest, LabelingIsPermutation) {
+  Canonizer<BasicGraph> canonizer;
+
+  petersen(&basic_graph);
+  canonizer.canonize(basic_graph);
+
+  vector<int> labels = canonizer.labeling();
+  std::sort(labels.begin(), labels.end());
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(i, labels[i]);
+  }
+}
+
+TEST_F(CanonizerTest, IsomorphicGraphsAgree) {
+  unsigned int x = 12345;
+  BasicGraph H;
+
+  for (int u = 0; u < 60; u++) {
+    x = x * 1103515245 + 12345;
+    basic_graph.add_edge(u, (x >> 8) % 60);
+  }
+
+  CompressedGraph<BasicGraph> canonical = canonical_graph(basic_graph);
+
+  for (int t = 0; t < 5; t++) {
+    permute(basic_graph, random_permutation(60, &x), &H);
+    EXPECT_EQ(0, canonical_graph(H).cmp(canonical) );
+  }
+
+  // and a regular graph, where the search is all individualization
+  petersen(&basic_graph);
+  canonical = canonical_graph(basic_graph);
+
+  for (int t = 0; t < 5; t++) {
+    permute(basic_graph, random_permutation(10, &x), &H);
+    EXPECT_EQ(0, canonical_graph(H).cmp(canonical) );
+  }
+}
+
+TEST_F(CanonizerTest, NonisomorphicGraphsDiffer) {
+  BasicGraph H;
+
+  // a hexagon and two triangles are both 2-regular on 6 vertices
+  for (int i = 0; i < 6; i++) {
+    basic_graph.add_edge(i, (i + 1) % 6);
+    H.add_edge(i, i / 3 * 3 + (i + 1) % 3);
+  }
+
+  EXPECT_NE(0, canonical_graph(basic_graph).cmp(canonical_graph(H)) );
+}
+
+TEST_F(CanonizerTest, ColorsAreRespected) {
+  PartitionNest colored_pi;
+  PartitionNest other_pi;
+
+  GraphIO::path(&basic_graph, 4);
+
+  // an end of the path colored apart, from either end
+  colored_pi.input_string("[ 0 | 1 2 3 ]");
+  other_pi.input_string("[ 3 | 0 1 2 ]");
+  EXPECT_EQ(0, canonical_graph(basic_graph, colored_pi).cmp(
+      canonical_graph(basic_graph, other_pi)) );
+
+  // but not a middle vertex
+  other_pi.input_string("[ 1 | 0 2 3 ]");
+  EXPECT_NE(0, canonical_graph(basic_graph, colored_pi).cmp(
+      canonical_graph(basic_graph, other_pi)) );
+}
+
+TEST_F(CanonizerTest, TracePrunes) {
+  Canonizer<BasicGraph> canonizer;
+
+  // the path's only symmetry is the reversal, so the refiner leaves little
+  // to search
+  GraphIO::path(&basic_graph, 9);
+  canonizer.canonize(basic_graph);
+
+  EXPECT_GE(canonizer.node_count(), 3);
+  EXPECT_LE(canonizer.node_count(), 9);
+}
+
+TEST_F(CanonizerTest, GeneratorsAreAutomorphisms) {
+  Canonizer<BasicGraph> canonizer;
+
+  petersen(&basic_graph);
+  canonizer.canonize(basic_graph);
+
+  EXPECT_LT(0, canonizer.generators().size());
+
+  for (int g = 0; g < canonizer.generators().size(); g++) {
+    EXPECT_TRUE(is_automorphism(basic_graph, &canonizer.generators()[g][0]));
+  }
+
+  // the Petersen graph is vertex transitive
+  EXPECT_EQ(1, canonizer.orbit_count());
+
+  for (int u = 0; u < 10; u++) {
+    EXPECT_EQ(0, canonizer.orbits()[u]);
+  }
+}
+
+TEST_F(CanonizerTest, Orbits) {
+  Canonizer<BasicGraph> canonizer;
+
+  // the reversal pairs up the path's vertices about the middle
+  GraphIO::path(&basic_graph, 9);
+  canonizer.canonize(basic_graph);
+
+  EXPECT_EQ(5, canonizer.orbit_count());
+
+  for (int u = 0; u < 9; u++) {
+    EXPECT_EQ(std::min(u, 8 - u), canonizer.orbits()[u]);
+  }
+
+  // a triangle and a square
+  basic_graph.clear();
+
+  for (int i = 0; i < 3; i++) {
+    basic_graph.add_edge(i, (i + 1) % 3);
+  }
+
+  for (int i = 0; i < 4; i++) {
+    basic_graph.add_edge(3 + i, 3 + (i + 1) % 4);
+  }
+
+  canonizer.canonize(basic_graph);
+
+  EXPECT_EQ(2, canonizer.orbit_count());
+
+  for (int u = 0; u < 7; u++) {
+    EXPECT_EQ(u < 3 ? 0 : 3, canonizer.orbits()[u]);
+  }
+}
+
+TEST_F(CanonizerTest, AutomorphismsPrune) {
+  Canonizer<BasicGraph> canonizer;
+  unsigned int x = 54321;
+  BasicGraph H;
+
+  // the 4-cube, with 384 automorphisms and as many leaves without pruning
+  for (int u = 0; u < 16; u++) {
+    for (int b = 1; b < 16; b <<= 1) {
+      if ((u & b) == 0) {
+        basic_graph.add_edge(u, u | b);
+      }
+    }
+  }
+
+  canonizer.canonize(basic_graph);
+
+  EXPECT_EQ(1, canonizer.orbit_count());
+  EXPECT_LT(canonizer.node_count(), 100);
+
+  CompressedGraph<BasicGraph> canonical = canonizer.canonical_graph();
+
+  for (int t = 0; t < 5; t++) {
+    permute(basic_graph, random_permutation(16, &x), &H);
+    EXPECT_EQ(0, canonical_graph(H).cmp(canonical) );
+  }
+}
+
+TEST_F(CanonizerTest, GroupOrder) {
+  Canonizer<BasicGraph> canonizer;
+
+  petersen(&basic_graph);
+  canonizer.canonize(basic_graph);
+  EXPECT_EQ("120", canonizer.group().order().to_string());
+
+  // ten triangles, with 6^10 10! automorphisms
+  basic_graph.clear();
+
+  for (int j = 0; j < 10; j++) {
+    for (int i = 0; i < 3; i++) {
+      basic_graph.add_edge(3 * j + i, 3 * j + (i + 1) % 3);
+    }
+  }
+
+  canonizer.canonize(basic_graph);
+  EXPECT_EQ("219419659468800", canonizer.group().order().to_string());
+  EXPECT_EQ(1, canonizer.orbit_count());
+
+  // the complete bipartite graph K_{20,20}, with 2 20!^2 automorphisms,
+  // which would be hopeless without pruning at every level
+  basic_graph.clear();
+
+  for (int u = 0; u < 20; u++) {
+    for (int v = 20; v < 40; v++) {
+      basic_graph.add_edge(u, v);
+    }
+  }
+
+  canonizer.canonize(basic_graph);
+  EXPECT_EQ("11838024362779855370834883379200000000",
+      canonizer.group().order().to_string());
+  EXPECT_LT(canonizer.node_count(), 2000);
+
+  for (int g = 0; g < canonizer.group().generator_count(); g++) {
+    EXPECT_TRUE(is_automorphism(basic_graph,
+        &canonizer.group().generator(g)[0]));
+  }
+}
+
+TEST_F(CanonizerTest, ThreadsAgree) {
+  Canonizer<BasicGraph> canonizer;
+  unsigned int x = 2468;
+  BasicGraph H;
+
+  // K_{5,5} and a random graph, relabeled for each thread count
+  for (int u = 0; u < 5; u++) {
+    for (int v = 5; v < 10; v++) {
+      basic_graph.add_edge(u, v);
+    }
+  }
+
+  for (int t = 0; t < 2; t++) {
+    canonizer.canonize(basic_graph);
+
+    for (int thread_count = 2; thread_count <= 4; thread_count++) {
+      Canonizer<BasicGraph> parallel_canonizer(thread_count);
+      CompressedGraph<BasicGraph> relabeled;
+
+      permute(basic_graph, random_permutation(basic_graph.vertex_count(), &x),
+          &H);
+      parallel_canonizer.canonize(H);
+      relabeled.assign_relabeled(H, &parallel_canonizer.labeling()[0]);
+
+      EXPECT_EQ(0, parallel_canonizer.canonical_graph().cmp(
+          canonizer.canonical_graph()) );
+      EXPECT_EQ(0, relabeled.cmp(parallel_canonizer.canonical_graph()) );
+      EXPECT_TRUE(parallel_canonizer.group().order()
+          == canonizer.group().order());
+      EXPECT_EQ(canonizer.orbit_count(), parallel_canonizer.orbit_count());
+    }
+
+    basic_graph.clear();
+    basic_graph.add_vertex(29);
+
+    for (int u = 0; u < 30; u++) {
+      x = x * 1103515245 + 12345;
+      basic_graph.add_edge(u, (x >> 8) % 30);
+    }
+  }
+}
+
+TEST_F(CanonizerTest, ThreadsAgreeOnGroupOrder) {
+  unsigned int x = 1357;
+  BasicGraph H;
+  int n = 0;
+
+  // three 3-cycles, two 4-cycles and two 5-cycles, whose automorphism group
+  // has order 6^3 3! 8^2 2! 10^2 2!
+  for (int length = 3; length <= 5; length++) {
+    for (int c = 0; c < (length == 3 ? 3 : 2); c++) {
+      for (int i = 0; i < length; i++) {
+        basic_graph.add_edge(n + i, n + (i + 1) % length);
+      }
+
+      n += length;
+    }
+  }
+
+  // the subtrees off the first path hold the automorphisms fixing it, and
+  // one of them dropped halves the order
+  for (int t = 0; t < 200; t++) {
+    for (int thread_count = 2; thread_count <= 4; thread_count++) {
+      Canonizer<BasicGraph> parallel_canonizer(thread_count);
+
+      permute(basic_graph, random_permutation(n, &x), &H);
+      parallel_canonizer.canonize(H);
+
+      EXPECT_EQ("33177600", parallel_canonizer.group().order().to_string());
+    }
+  }
+}
+
+}  // namespace nishe
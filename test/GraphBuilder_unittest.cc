@@ -0,0 +1,224 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/test/BaseNisheTest.h>
+
+#include <nishe/Graphs.h>
+#include <nishe/GraphBuilder.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <algorithm>
+
+using std::vector;
+using std::sort;
+
+namespace nishe {
+
+class GraphBuilderTest: public BaseNisheTest {
+ public:
+  vector<vertex_t> us;
+  vector<vertex_t> vs;
+  vector<int> weights;
+
+  // a pseudorandom list of arcs with repeats, reverses and loops
+  void make_arcs(int arc_count, int n) {
+    unsigned int x = 12345;
+
+    us.clear();
+    vs.clear();
+    weights.clear();
+
+    for (int i = 0; i < arc_count; i++) {
+      x = x * 1103515245 + 12345;
+      us.push_back((x >> 8) % n);
+      x = x * 1103515245 + 12345;
+      vs.push_back((x >> 8) % n);
+      weights.push_back(i % 5);
+    }
+  }
+
+  // nbhds only have to match up to the order of their nbhrs
+  template<typename graph_t>
+  void check_same_graph(const graph_t &G, const graph_t &H) {
+    ASSERT_EQ(G.vertex_count(), H.vertex_count() );
+
+    for (int u = 0; u < G.vertex_count(); u++) {
+      vector<typename graph_t::nbhr> g_nbhd(G.get_nbhd(u),
+          G.get_nbhd(u) + G.get_nbhd_size(u) );
+      vector<typename graph_t::nbhr> h_nbhd(H.get_nbhd(u),
+          H.get_nbhd(u) + H.get_nbhd_size(u) );
+
+      sort(g_nbhd.begin(), g_nbhd.end() );
+      sort(h_nbhd.begin(), h_nbhd.end() );
+
+      ASSERT_EQ(g_nbhd, h_nbhd);
+    }
+  }
+
+  void check_all_types(int arc_count, int n, int thread_count) {
+    GraphBuilder builder(thread_count);
+    BasicGraph built_basic;
+    DirectedGraph built_directed;
+    IntegerWeightedGraph built_weighted;
+    IntegerWeightedGraph weighted_edges_graph;
+    IntegerWeightedGraph built_weighted_edges;
+    PackedDirectedGraph built_packed;
+
+    make_arcs(arc_count, n);
+
+    basic_graph.clear();
+    directed_graph.clear();
+    integer_weighted_graph.clear();
+    packed_directed_graph.clear();
+
+    for (int i = 0; i < arc_count; i++) {
+      basic_graph.add_edge(us[i], vs[i]);
+      directed_graph.add_arc(us[i], vs[i]);
+      integer_weighted_graph.add_weighted_arc(us[i], vs[i], weights[i]);
+      weighted_edges_graph.add_weighted_edge(us[i], vs[i], weights[i]);
+      packed_directed_graph.add_arc(us[i], vs[i]);
+    }
+
+    builder.add_edges(&us[0], &vs[0], arc_count);
+    builder.finalize(&built_basic);
+    check_same_graph(basic_graph, built_basic);
+
+    builder.add_arcs(&us[0], &vs[0], arc_count);
+    builder.finalize(&built_directed);
+    check_same_graph(directed_graph, built_directed);
+
+    builder.add_weighted_arcs(&us[0], &vs[0], &weights[0], arc_count);
+    builder.finalize(&built_weighted);
+    check_same_graph(integer_weighted_graph, built_weighted);
+
+    builder.add_weighted_edges(&us[0], &vs[0], &weights[0], arc_count);
+    builder.finalize(&built_weighted_edges);
+    check_same_graph(weighted_edges_graph, built_weighted_edges);
+
+    builder.add_arcs(&us[0], &vs[0], arc_count);
+    builder.finalize(&built_packed);
+    check_same_graph(packed_directed_graph, built_packed);
+  }
+};
+
+TEST_F(GraphBuilderTest, FinalizeEmpty) {
+  GraphBuilder builder;
+
+  builder.finalize(&basic_graph);
+  EXPECT_EQ(0, basic_graph.vertex_count() );
+
+  builder.add_vertex(2);
+  builder.finalize(&basic_graph);
+  EXPECT_EQ(3, basic_graph.vertex_count() );
+  EXPECT_EQ(0, basic_graph.get_nbhd_size(2) );
+}
+
+TEST_F(GraphBuilderTest, FinalizeDirectedBoth) {
+  GraphBuilder builder;
+  vertex_t us[] = {0, 1, 1, 0};
+  vertex_t vs[] = {1, 0, 2, 1};
+
+  builder.add_arcs(us, vs, 4);
+  builder.finalize(&directed_graph);
+
+  ASSERT_EQ(3, directed_graph.vertex_count() );
+  ASSERT_EQ(1, directed_graph.get_nbhd_size(0) );
+  ASSERT_EQ(2, directed_graph.get_nbhd_size(1) );
+  ASSERT_EQ(1, directed_graph.get_nbhd_size(2) );
+
+  EXPECT_EQ(DirectedGraph::nbhr(1, DirectedGraph::BOTH),
+      directed_graph.get_nbhd(0)[0]);
+  EXPECT_EQ(DirectedGraph::nbhr(0, DirectedGraph::BOTH),
+      directed_graph.get_nbhd(1)[0]);
+  EXPECT_EQ(DirectedGraph::nbhr(2, DirectedGraph::OUT),
+      directed_graph.get_nbhd(1)[1]);
+  EXPECT_EQ(DirectedGraph::nbhr(1, DirectedGraph::IN),
+      directed_graph.get_nbhd(2)[0]);
+}
+
+// the first weight given to an arc is the one that is kept
+TEST_F(GraphBuilderTest, FinalizeWeightedKeepsFirst) {
+  GraphBuilder builder;
+  vertex_t us[] = {0, 0};
+  vertex_t vs[] = {1, 1};
+  int ws[] = {7, 3};
+
+  builder.add_weighted_edges(us, vs, ws, 2);
+  builder.finalize(&integer_weighted_graph);
+
+  ASSERT_EQ(1, integer_weighted_graph.get_nbhd_size(0) );
+  EXPECT_EQ(IntegerWeightedGraph::nbhr(1, 7),
+      integer_weighted_graph.get_nbhd(0)[0]);
+  EXPECT_EQ(IntegerWeightedGraph::nbhr(0, 7),
+      integer_weighted_graph.get_nbhd(1)[0]);
+}
+
+// an edge's reverse comes before the arcs of the edges after it
+TEST_F(GraphBuilderTest, FinalizeWeightedEdgesInOrder) {
+  GraphBuilder builder;
+  vertex_t us[] = {0, 1};
+  vertex_t vs[] = {1, 0};
+  int ws[] = {5, 7};
+
+  builder.add_weighted_edges(us, vs, ws, 2);
+  builder.finalize(&integer_weighted_graph);
+
+  ASSERT_EQ(1, integer_weighted_graph.get_nbhd_size(0) );
+  ASSERT_EQ(1, integer_weighted_graph.get_nbhd_size(1) );
+  EXPECT_EQ(IntegerWeightedGraph::nbhr(1, 5),
+      integer_weighted_graph.get_nbhd(0)[0]);
+  EXPECT_EQ(IntegerWeightedGraph::nbhr(0, 5),
+      integer_weighted_graph.get_nbhd(1)[0]);
+}
+
+// an indexed graph stays indexed, so adding an arc it has is a no op
+TEST_F(GraphBuilderTest, FinalizeIndexed) {
+  GraphBuilder builder;
+  vertex_t us[] = {0, 1};
+  vertex_t vs[] = {1, 2};
+
+  basic_graph.set_indexed(true);
+  builder.add_edges(us, vs, 2);
+  builder.finalize(&basic_graph);
+
+  EXPECT_TRUE(basic_graph.is_indexed() );
+  EXPECT_EQ(0, basic_graph.find_nbhr(0, 1) );
+  EXPECT_FALSE(basic_graph.add_edge(0, 1) );
+  EXPECT_EQ(1, basic_graph.get_nbhd_size(0) );
+
+  directed_graph.set_indexed(true);
+  builder.add_arcs(us, vs, 2);
+  builder.finalize(&directed_graph);
+
+  EXPECT_FALSE(directed_graph.add_arc(0, 1) );
+  EXPECT_EQ(1, directed_graph.get_nbhd_size(0) );
+
+  // the reverse of an arc turns it into BOTH rather than a second nbhr
+  directed_graph.add_arc(2, 1);
+  ASSERT_EQ(1, directed_graph.get_nbhd_size(2) );
+  EXPECT_EQ(DirectedGraph::nbhr(1, DirectedGraph::BOTH),
+      directed_graph.get_nbhd(2)[0]);
+
+  integer_weighted_graph.set_indexed(true);
+  builder.add_edges(us, vs, 2);
+  builder.finalize(&integer_weighted_graph);
+
+  EXPECT_FALSE(integer_weighted_graph.add_weighted_edge(1, 2, 4) );
+  EXPECT_EQ(2, integer_weighted_graph.get_nbhd_size(1) );
+}
+
+TEST_F(GraphBuilderTest, FinalizeMatchesAddArc) {
+  check_all_types(500, 20, 1);
+  check_all_types(3000, 1000, 1);
+}
+
+// enough arcs that the sort is split between threads
+TEST_F(GraphBuilderTest, FinalizeParallelMatchesAddArc) {
+  check_all_types(100000, 700, 4);
+}
+
+}  // namespace nishe
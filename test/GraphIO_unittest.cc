@@ -11,8 +11,13 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdlib>
 #include <utility>
 #include <fstream>
+#include <vector>
 
 using std::ifstream;
 using std::make_pair;
@@ -22,6 +27,14 @@ namespace nishe {
 
 class GraphIOTest: public BaseNisheTest {
  public:
+  // the binary files written by the test, removed when it is done
+  std::vector<string> binary_paths;
+
+  ~GraphIOTest() {
+    for (size_t i = 0; i < binary_paths.size(); i++) {
+      unlink(binary_paths[i].c_str());
+    }
+  }
 
   template<typename graph_t>
   void check_invalid_vertex(graph_t *pG, string s, string line) {
@@ -57,6 +70,39 @@ class GraphIOTest: public BaseNisheTest {
     EXPECT_DEATH(input_graph(pG, s), err);
   }
 
+  // writes G and pi to a new temporary binary file, returns its path
+  template <typename graph_t>
+  string output_binary_file(const graph_t &G, const PartitionNest *pi_ptr) {
+    char path[] = "/tmp/nishe_GraphIO_unittest.XXXXXX";
+    int fd = mkstemp(path);
+
+    if (fd == -1) {
+      fprintf(stderr, "couldn't create a temporary file\n");
+      exit(1);
+    }
+
+    close(fd);
+    binary_paths.push_back(path);
+
+    std::ofstream out(path, std::ios::binary);
+
+    GraphIO::output_binary(out, G, pi_ptr);
+    out.close();
+
+    return path;
+  }
+
+  // overwrites size bytes of the file at path, starting at offset
+  void patch_binary_file(string path, size_t offset, const void *bytes,
+      size_t size) {
+    std::fstream file(path.c_str(),
+        std::ios::in | std::ios::out | std::ios::binary);
+
+    file.seekp(offset);
+    file.write(static_cast<const char *>(bytes), size);
+    file.close();
+  }
+
   void check_invalid_token(IntegerWeightedGraph *pG, string s, string token) {
     string err = "Error Error Examine: ";
     err += "expected <v>,<w> token for integer weighted edge, got ";
@@ -226,6 +272,119 @@ TEST_F(GraphIOTest, ConvertDirectedToIntegerWeighted) {
         integer_weighted_graph.get_nbhd(1)[0] );
 }
 
+TEST_F(GraphIOTest, ConvertDirectedToPacked) {
+  input_graph(&directed_graph, "0 : 1 ;\n1 : 0 2 ;");
+
+  GraphIO::convert(directed_graph, &packed_directed_graph);
+
+  EXPECT_STREQ(output_graph(directed_graph).c_str(),
+      output_graph(packed_directed_graph).c_str() );
+
+  DirectedGraph unpacked;
+  GraphIO::convert(packed_directed_graph, &unpacked);
+
+  EXPECT_STREQ(output_graph(directed_graph).c_str(),
+      output_graph(unpacked).c_str() );
+}
+
+TEST_F(GraphIOTest, InputDimacsBasicGraphColored) {
+  stringstream ss("c a path with colors\np edge 4 3\nn 2 5\nn 3 1\n"
+      "e 1 2\ne 2 3\ne 3 4\n");
+
+  ASSERT_TRUE(GraphIO::input_dimacs(ss, &basic_graph, &pi) );
+
+  EXPECT_STREQ("0 : 1 ;\n1 : 0 2 ;\n2 : 1 3 ;\n3 : 2 ;",
+      output_graph(basic_graph).c_str() );
+  EXPECT_STREQ("[ 0 3 | 2 | 1 ]", pi.str().c_str() );
+}
+
+TEST_F(GraphIOTest, InputDimacsDirectedGraph) {
+  stringstream ss("p edge 3 3\ne 1 2\ne 2 1\ne 3 1\n");
+
+  ASSERT_TRUE(GraphIO::input_dimacs(ss, &directed_graph, &pi) );
+
+  ASSERT_EQ(3, directed_graph.vertex_count() );
+  ASSERT_EQ(2, directed_graph.get_nbhd_size(0) );
+  EXPECT_EQ(DirectedGraph::nbhr(1, DirectedGraph::BOTH),
+      directed_graph.get_nbhd(0)[0]);
+  EXPECT_EQ(DirectedGraph::nbhr(2, DirectedGraph::IN),
+      directed_graph.get_nbhd(0)[1]);
+  EXPECT_EQ(DirectedGraph::nbhr(0, DirectedGraph::OUT),
+      directed_graph.get_nbhd(2)[0]);
+  EXPECT_STREQ("[ 0:2 ]", pi.str().c_str() );
+}
+
+TEST_F(GraphIOTest, InputDimacsEmpty) {
+  stringstream ss("c nothing here\n");
+
+  EXPECT_FALSE(GraphIO::input_dimacs(ss, &basic_graph, &pi) );
+}
+
+TEST_F(GraphIOTest, BinaryDirectedGraphRoundTrip) {
+  input_graph(&directed_graph, "0 : 1 ;\n1 : 0 2 ;\n[ 2 | 0 1 ]");
+
+  string path = output_binary_file(directed_graph, &pi);
+
+  CompressedGraph<DirectedGraph> mapped;
+  PartitionNest mapped_pi;
+
+  ASSERT_TRUE(GraphIO::input_binary(path, &mapped, &mapped_pi) );
+  EXPECT_TRUE(mapped.is_view() );
+  ASSERT_EQ(directed_graph.vertex_count(), mapped.vertex_count() );
+
+  for (int u = 0; u < mapped.vertex_count(); u++) {
+    ASSERT_EQ(directed_graph.get_nbhd_size(u), mapped.get_nbhd_size(u) );
+
+    for (int i = 0; i < mapped.get_nbhd_size(u); i++) {
+      EXPECT_EQ(directed_graph.get_nbhd(u)[i], mapped.get_nbhd(u)[i]);
+    }
+  }
+
+  EXPECT_STREQ(pi.str().c_str(), mapped_pi.str().c_str() );
+
+  // a copy keeps the file mapped after the original is gone
+  CompressedGraph<DirectedGraph> copy(mapped);
+  mapped.clear();
+
+  EXPECT_TRUE(copy.is_view() );
+  EXPECT_EQ(4, copy.arc_count() );
+  EXPECT_EQ(DirectedGraph::BOTH, copy.nbhr_attr(copy.get_nbhd(1)[0]) );
+}
+
+TEST_F(GraphIOTest, BinaryWithoutPartition) {
+  input_graph(&basic_graph, "0 : 1 ;\n2 : ;");
+
+  string path = output_binary_file(CompressedGraph<BasicGraph>(basic_graph),
+      NULL);
+
+  CompressedGraph<BasicGraph> mapped;
+
+  ASSERT_TRUE(GraphIO::input_binary(path, &mapped, &pi) );
+  EXPECT_EQ(3, mapped.vertex_count() );
+  EXPECT_EQ(0, mapped.get_nbhd_size(2) );
+  EXPECT_STREQ("[ 0:2 ]", pi.str().c_str() );
+}
+
+TEST_F(GraphIOTest, BinaryMissingFile) {
+  CompressedGraph<BasicGraph> mapped;
+
+  EXPECT_FALSE(GraphIO::input_binary("/nonexistent/graph.bin", &mapped, &pi) );
+}
+
+TEST_F(GraphIOTest, ConvertIntegerWeightedToEdgeColored) {
+  input_graph(&integer_weighted_graph, "0 : 1,100 2,-5 ;\n1 : 2,7 ;");
+
+  EdgeColoredGraph<3> colored_graph;
+  GraphIO::convert(integer_weighted_graph, &colored_graph);
+
+  // -5, 7, 100 become 0, 1, 2
+  ASSERT_EQ(3, colored_graph.vertex_count() );
+  ASSERT_EQ(2, colored_graph.get_nbhd_size(0) );
+  EXPECT_EQ(EdgeColoredGraph<3>::nbhr(1, 2), colored_graph.get_nbhd(0)[0]);
+  EXPECT_EQ(EdgeColoredGraph<3>::nbhr(2, 0), colored_graph.get_nbhd(0)[1]);
+  EXPECT_EQ(EdgeColoredGraph<3>::nbhr(2, 1), colored_graph.get_nbhd(1)[1]);
+}
+
 typedef GraphIOTest GraphIODeathTest;
 
 /*
@@ -272,6 +431,92 @@ TEST_F(GraphIODeathTest, InputListAsciiColoredGraphWrongPartitionSize) {
   check_wrong_partition_size(&basic_graph, "0 : 1 ;\n[ 0:2 ]", 2, 3);
 }
 
-}  // namespace nishe
+TEST_F(GraphIODeathTest, InputDimacsInvalidVertex) {
+  stringstream ss("p edge 2 1\ne 1 3\n");
+
+  EXPECT_DEATH(GraphIO::input_dimacs(ss, &basic_graph, &pi),
+      "Error Error Examine: expected a vertex from 1 to 2 on an e line");
+}
+
+TEST_F(GraphIODeathTest, ConvertTooManyColors) {
+  input_graph(&integer_weighted_graph, "0 : 1,1 2,2 3,3 ;");
+
+  EdgeColoredGraph<2> colored_graph;
+
+  EXPECT_DEATH(GraphIO::convert(integer_weighted_graph, &colored_graph),
+      "Error Error Examine: graph has 3 distinct weights but only 2 colors");
+}
+
+TEST_F(GraphIODeathTest, BinaryWrongGraphType) {
+  input_graph(&basic_graph, "0 : 1 ;");
+
+  string path = output_binary_file(basic_graph, NULL);
+
+  CompressedGraph<DirectedGraph> mapped;
+
+  EXPECT_DEATH(GraphIO::input_binary(path, &mapped, &pi),
+      "Error Error Examine: binary graph file was written for a different");
+}
+
+TEST_F(GraphIODeathTest, BinaryNbhrNotAVertex) {
+  input_graph(&basic_graph, "0 : 1 ;");
 
+  string path = output_binary_file(basic_graph, NULL);
+  BasicGraph::nbhr nbhr = 2;
 
+  // the first nbhr, after the header and the 3 offsets
+  patch_binary_file(path, sizeof(BinaryHeader) + 3 * sizeof(uint64_t), &nbhr,
+      sizeof(nbhr));
+
+  CompressedGraph<BasicGraph> mapped;
+
+  EXPECT_DEATH(GraphIO::input_binary(path, &mapped, &pi),
+      "Error Error Examine: binary graph file has a nbhr that is not a vertex");
+}
+
+TEST_F(GraphIODeathTest, BinaryNbhrInvalidAttr) {
+  input_graph(&directed_graph, "0 : 1 ;");
+
+  string path = output_binary_file(directed_graph, NULL);
+  DirectedGraph::nbhr nbhr = DirectedGraph::make_nbhr(1, 1000);
+
+  patch_binary_file(path, sizeof(BinaryHeader) + 3 * sizeof(uint64_t), &nbhr,
+      sizeof(nbhr));
+
+  CompressedGraph<DirectedGraph> mapped;
+
+  EXPECT_DEATH(GraphIO::input_binary(path, &mapped, &pi),
+      "Error Error Examine: binary graph file has a nbhr with an invalid attr");
+
+  // the 2 type bits of a packed nbhr can hold one more than BOTH
+  input_graph(&packed_directed_graph, "0 : 1 ;");
+
+  path = output_binary_file(packed_directed_graph, NULL);
+  PackedDirectedGraph::nbhr packed_nbhr = PackedDirectedGraph::make_nbhr(1,
+      PackedDirectedGraph::BOTH + 1);
+
+  patch_binary_file(path, sizeof(BinaryHeader) + 3 * sizeof(uint64_t),
+      &packed_nbhr, sizeof(packed_nbhr));
+
+  CompressedGraph<PackedDirectedGraph> packed_mapped;
+
+  EXPECT_DEATH(GraphIO::input_binary(path, &packed_mapped, &pi),
+      "Error Error Examine: binary graph file has a nbhr with an invalid attr");
+}
+
+TEST_F(GraphIODeathTest, BinaryTooManyVertices) {
+  input_graph(&basic_graph, "0 : 1 ;");
+
+  string path = output_binary_file(basic_graph, NULL);
+  uint64_t vertex_count = 1ULL << 32;
+
+  patch_binary_file(path, offsetof(BinaryHeader, vertex_count),
+      &vertex_count, sizeof(vertex_count));
+
+  CompressedGraph<BasicGraph> mapped;
+
+  EXPECT_DEATH(GraphIO::input_binary(path, &mapped, &pi),
+      "Error Error Examine: binary graph file has more vertices than an int");
+}
+
+}  // namespace nishe
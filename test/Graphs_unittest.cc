@@ -43,6 +43,19 @@ class GraphsTest: public BaseNisheTest {
     EXPECT_EQ(3, G.vertex_count() );
   }
 
+  template <typename graph_t>
+  void check_same_nbhds(const graph_t &G, const graph_t &H) {
+    ASSERT_EQ(G.vertex_count(), H.vertex_count() );
+
+    for (int u = 0; u < G.vertex_count(); u++) {
+      ASSERT_EQ(G.get_nbhd_size(u), H.get_nbhd_size(u) );
+
+      for (int i = 0; i < G.get_nbhd_size(u); i++) {
+        EXPECT_EQ(G.get_nbhd(u)[i], H.get_nbhd(u)[i]);
+      }
+    }
+  }
+
   template <typename graph_t>
   void check_is_rigid(const graph_t &G) {
     vector<int> x(G.vertex_count() );
@@ -61,6 +74,7 @@ TEST_F(GraphsTest, AddVertices) {
   check_add_vertex(&basic_graph);
   check_add_vertex(&directed_graph);
   check_add_vertex(&integer_weighted_graph);
+  check_add_vertex(&packed_directed_graph);
 }
 
 /*
@@ -109,6 +123,34 @@ TEST_F(GraphsTest, DirectedGraphAddArc) {
       directed_graph.get_nbhd(1)[0]);
 }
 
+/*
+ * Same as DirectedGraphAddArc, with the arc types packed into the nbhrs
+ */
+TEST_F(GraphsTest, PackedDirectedGraphAddArc) {
+  EXPECT_TRUE(packed_directed_graph.add_arc(0, 1));
+  EXPECT_FALSE(packed_directed_graph.add_arc(0, 1));
+
+  ASSERT_EQ(1, packed_directed_graph.get_nbhd_size(0));
+  ASSERT_EQ(1, packed_directed_graph.get_nbhd_size(1));
+
+  const PackedDirectedGraph::nbhr &out = packed_directed_graph.get_nbhd(0)[0];
+  EXPECT_EQ(1, PackedDirectedGraph::vertex_of(out));
+  EXPECT_EQ(PackedDirectedGraph::OUT, PackedDirectedGraph::attr_of(out));
+  EXPECT_EQ(PackedDirectedGraph::make_nbhr(0, PackedDirectedGraph::IN),
+      packed_directed_graph.get_nbhd(1)[0]);
+
+  // make symmetric arc
+  EXPECT_TRUE(packed_directed_graph.add_arc(1, 0));
+
+  EXPECT_EQ(PackedDirectedGraph::make_nbhr(1, PackedDirectedGraph::BOTH),
+      packed_directed_graph.get_nbhd(0)[0]);
+  EXPECT_EQ(PackedDirectedGraph::make_nbhr(0, PackedDirectedGraph::BOTH),
+      packed_directed_graph.get_nbhd(1)[0]);
+
+  // a nbhr is one vertex wide
+  EXPECT_EQ(sizeof(vertex_t), sizeof(PackedDirectedGraph::nbhr));
+}
+
 /*
  * Add the weighted edge (0, 1, 2) and make sure it shows up
  */
@@ -129,10 +171,131 @@ TEST_F(GraphsTest, IntegerWeightedGraphAddArc) {
       integer_weighted_graph.get_nbhd(1)[0]);
 }
 
+/*
+ * Indexing the arcs must not change what gets added, including the
+ * upgrade of an IN arc to BOTH in a directed graph
+ */
+TEST_F(GraphsTest, IndexedAddArcMatchesScan) {
+  BasicGraph indexed_basic;
+  DirectedGraph indexed_directed;
+  IntegerWeightedGraph indexed_weighted;
+
+  indexed_basic.set_indexed(true);
+  indexed_directed.set_indexed(true);
+  indexed_weighted.set_indexed(true);
+
+  // a pseudorandom multigraph with repeated arcs and self loops
+  for (int i = 0; i < 200; i++) {
+    vertex_t u = (i * 7) % 13;
+    vertex_t v = (i * i + 3) % 11;
+
+    EXPECT_EQ(basic_graph.add_edge(u, v), indexed_basic.add_edge(u, v));
+    EXPECT_EQ(directed_graph.add_arc(u, v), indexed_directed.add_arc(u, v));
+    EXPECT_EQ(integer_weighted_graph.add_weighted_edge(u, v, i % 3),
+        indexed_weighted.add_weighted_edge(u, v, i % 3));
+  }
+
+  check_same_nbhds(basic_graph, indexed_basic);
+  check_same_nbhds(directed_graph, indexed_directed);
+  check_same_nbhds(integer_weighted_graph, indexed_weighted);
+
+  // turning the index on afterwards must pick up the arcs already there
+  directed_graph.set_indexed(true);
+  indexed_directed.set_indexed(false);
+
+  for (vertex_t u = 0; u < 13; u++) {
+    EXPECT_EQ(directed_graph.add_arc(u, 12 - u),
+        indexed_directed.add_arc(u, 12 - u));
+  }
+
+  check_same_nbhds(directed_graph, indexed_directed);
+}
+
+/*
+ * The static accessors and the polymorphic ones must decode the same way
+ */
+TEST_F(GraphsTest, NbhrAccessors) {
+  GraphIO::directed_path(&directed_graph, 2);
+
+  const DirectedGraph::nbhr &nbhr = directed_graph.get_nbhd(1)[0];
+  const Graph<DirectedGraph, DirectedGraph::nbhr, DirectedGraph::attr,
+      DirectedGraph::attr_sum> &G = directed_graph;
+
+  EXPECT_EQ(0, DirectedGraph::vertex_of(nbhr));
+  EXPECT_EQ(DirectedGraph::IN, DirectedGraph::attr_of(nbhr));
+  EXPECT_EQ(DirectedGraph::vertex_of(nbhr), G.nbhr_vertex(nbhr));
+  EXPECT_EQ(DirectedGraph::attr_of(nbhr), G.nbhr_attr(nbhr));
+
+  EXPECT_EQ(3, BasicGraph::vertex_of(3));
+  EXPECT_EQ(1, BasicGraph::attr_of(3));
+}
+
 /*
  * Test the is_automorphism function
  */
 
+TEST_F(GraphsTest, EdgeColoredGraphAddArc) {
+  EdgeColoredGraph<3> colored_graph;
+
+  EXPECT_TRUE(colored_graph.add_colored_edge(0, 1, 2) );
+  EXPECT_FALSE(colored_graph.add_colored_arc(0, 1, 1) );
+  EXPECT_TRUE(colored_graph.add_colored_arc(1, 2, 0) );
+
+  ASSERT_EQ(3, colored_graph.vertex_count() );
+  ASSERT_EQ(2, colored_graph.get_nbhd_size(1) );
+  EXPECT_EQ(2, EdgeColoredGraph<3>::attr_of(colored_graph.get_nbhd(0)[0]) );
+  EXPECT_EQ(0, EdgeColoredGraph<3>::attr_of(colored_graph.get_nbhd(1)[1]) );
+
+  // sow 1's nbhrs
+  EdgeColoredGraph<3>::attr_sum sum;
+  sum = 0;
+  sum += 2;
+  sum += 0;
+  sum += 2;
+
+  EXPECT_EQ(1, sum.counts[0]);
+  EXPECT_EQ(0, sum.counts[1]);
+  EXPECT_EQ(2, sum.counts[2]);
+}
+
+TEST_F(GraphsTest, DenseGraphInRows) {
+  basic_graph.add_arc(0, 2);
+  basic_graph.add_arc(1, 2);
+  basic_graph.add_arc(2, 70);
+
+  DenseGraph dense_graph(basic_graph);
+
+  ASSERT_EQ(71, dense_graph.vertex_count() );
+  ASSERT_EQ(2, dense_graph.row_words() );
+
+  // 2 is a nbhr of 0 and 1, 70 is a nbhr of 2
+  EXPECT_EQ(3ULL, dense_graph.in_row(2)[0]);
+  EXPECT_EQ(0ULL, dense_graph.in_row(2)[1]);
+  EXPECT_EQ(4ULL, dense_graph.in_row(70)[0]);
+  EXPECT_EQ(0ULL, dense_graph.in_row(0)[0]);
+
+  EXPECT_EQ(3, dense_graph.get_nbhd_size(0) + dense_graph.get_nbhd_size(1)
+      + dense_graph.get_nbhd_size(2) );
+}
+
+TEST_F(GraphsTest, AndPopcount) {
+  vector<uint64_t> a(11);
+  vector<uint64_t> b(11);
+  size_t expected = 0;
+
+  for (int i = 0; i < a.size(); i++) {
+    a[i] = 0x0123456789abcdefULL * (i + 1);
+    b[i] = ~0ULL >> i;
+
+    for (int bit = 0; bit < 64; bit++) {
+      expected += ((a[i] & b[i]) >> bit) & 1;
+    }
+  }
+
+  EXPECT_EQ(expected, and_popcount(&a[0], &b[0], a.size() ));
+  EXPECT_EQ(0, and_popcount(&a[0], &b[0], 0) );
+}
+
 TEST_F(GraphsTest, IsAutomorphismPath3) {
   GraphIO::path(&basic_graph, 3);
   vector<int> x(basic_graph.vertex_count() );
@@ -164,6 +327,53 @@ TEST_F(GraphsTest, IsAutomorphismDirectedPath3) {
   check_is_rigid(directed_graph);
 }
 
-}  // namespace nishe
+/*
+ * A compressed graph should have exactly the nbhds of what it was built from
+ */
+TEST_F(GraphsTest, CompressedGraphCopiesNbhds) {
+  GraphIO::directed_path(&directed_graph, 3);
+  directed_graph.add_arc(1, 0);
 
+  CompressedGraph<DirectedGraph> compressed(directed_graph);
 
+  ASSERT_EQ(directed_graph.vertex_count(), compressed.vertex_count());
+  EXPECT_EQ(4, compressed.arc_count());
+
+  for (int u = 0; u < directed_graph.vertex_count(); u++) {
+    ASSERT_EQ(directed_graph.get_nbhd_size(u), compressed.get_nbhd_size(u));
+
+    for (int i = 0; i < directed_graph.get_nbhd_size(u); i++) {
+      EXPECT_EQ(directed_graph.get_nbhd(u)[i], compressed.get_nbhd(u)[i]);
+    }
+  }
+
+  EXPECT_EQ(DirectedGraph::BOTH,
+      compressed.nbhr_attr(compressed.get_nbhd(0)[0]));
+  EXPECT_EQ(DirectedGraph::OUT,
+      compressed.nbhr_attr(compressed.get_nbhd(1)[1]));
+}
+
+TEST_F(GraphsTest, IsAutomorphismCompressedPath3) {
+  GraphIO::path(&basic_graph, 3);
+  CompressedGraph<BasicGraph> compressed(basic_graph);
+  int x[] = {2, 1, 0};
+
+  EXPECT_TRUE(is_automorphism(compressed, x));
+
+  GraphIO::directed_path(&directed_graph, 3);
+  check_is_rigid(CompressedGraph<DirectedGraph>(directed_graph));
+}
+
+typedef GraphsTest GraphsDeathTest;
+
+// a vertex past max_vertex() would lose its top bits in a nbhr
+TEST_F(GraphsDeathTest, PackedDirectedGraphVertexTooLarge) {
+  vertex_t v = PackedDirectedGraph::max_vertex();
+
+  EXPECT_EQ(v, PackedDirectedGraph::vertex_of(
+      PackedDirectedGraph::make_nbhr(v, PackedDirectedGraph::BOTH)));
+  EXPECT_DEATH(packed_directed_graph.add_arc(0, v + 1),
+      "Error Error Examine: vertex is too large for a packed nbhr");
+}
+
+}  // namespace nishe
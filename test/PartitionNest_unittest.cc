@@ -268,6 +268,117 @@ TEST_F(PartitionNestTest, BreakoutSmall) {
   check_partition_integrity(pi);
 }
 
+TEST_F(PartitionNestTest, BreakoutAfterRecover) {
+  input("[ 4 2 0 | 3 1 ]");
+
+  pi.advance_level();
+  pi.breakout(0);
+  pi.breakout(1);
+  EXPECT_STREQ("[ 0 | 2 4 | 1 | 3 ]", pi.str().c_str() );
+
+  // the elements stay where the breakouts put them
+  pi.recover_level(0);
+  EXPECT_STREQ("[ 0 2 4 | 1 3 ]", pi.str().c_str() );
+
+  // 4 is swapped with the front of the cell
+  pi.breakout(4);
+  EXPECT_STREQ("[ 4 | 0 2 | 1 3 ]", pi.str().c_str() );
+  EXPECT_EQ(2, pi.elements()[1]);
+  EXPECT_EQ(0, pi.elements()[2]);
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(i, pi.position_of(pi.elements()[i]) );
+  }
+
+  check_partition_integrity(pi);
+}
+
+// splits and merges relabel whichever part is smaller
+TEST_F(PartitionNestTest, BreakoutDownAndBack) {
+  vector<string> levels;
+
+  pi.unit(9);
+  levels.push_back(pi.str());
+
+  // a split whose first part is the larger, then breakouts to the bottom
+  pi.advance_level();
+  pi.add_index(6);
+  levels.push_back(pi.str());
+  check_partition_integrity(pi);
+
+  while (!pi.is_discrete()) {
+    int k = pi.first_nontrivial_index();
+
+    pi.advance_level();
+    pi.breakout(pi.elements()[k + pi.cell_size(k) - 1]);
+    levels.push_back(pi.str());
+    check_partition_integrity(pi);
+  }
+
+  EXPECT_STREQ("[ 5 | 0 | 1 | 2 | 3 | 4 | 8 | 6 | 7 ]", pi.str().c_str() );
+
+  for (int m = levels.size() - 2; m >= 0; m--) {
+    pi.recover_level(m);
+    EXPECT_EQ(levels[m], pi.str());
+    check_partition_integrity(pi);
+  }
+}
+
+TEST_F(PartitionNestTest, PositionOf) {
+  input("[ 3 1 | 0 2 ]");
+
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(i, pi.position_of(pi.elements()[i]) );
+  }
+
+  pi.swap_elements(2, 3);
+  EXPECT_EQ(2, pi.position_of(2) );
+  EXPECT_EQ(3, pi.position_of(0) );
+  check_partition_integrity(pi);
+}
+
+TEST_F(PartitionNestTest, ColoredSmall) {
+  unsigned int colors[] = {7, 0, 7, 300, 0};
+
+  pi.colored(5, colors);
+  EXPECT_STREQ("[ 1 4 | 0 2 | 3 ]", pi.str().c_str() );
+  check_partition_integrity(pi);
+
+  // the elements of each cell stay in increasing order
+  EXPECT_EQ(1, pi.elements()[0]);
+  EXPECT_EQ(4, pi.elements()[1]);
+}
+
+TEST_F(PartitionNestTest, ColoredMatchesInput) {
+  vector<unsigned int> colors(1000);
+  stringstream ss;
+
+  for (int u = 0; u < colors.size(); u++) {
+    colors[u] = (u * 7919) % 13 * 100003;
+  }
+
+  // the same partition written out cell by cell
+  ss << "[";
+
+  for (int c = 0; c < 13; c++) {
+    ss << (c > 0 ? " |" : "");
+
+    for (int u = 0; u < colors.size(); u++) {
+      if (colors[u] == c * 100003) {
+        ss << " " << u;
+      }
+    }
+  }
+
+  ss << " ]";
+
+  pi.colored(colors.size(), &colors[0]);
+  pi2.input_string(ss.str() );
+
+  EXPECT_STREQ(pi2.str().c_str(), pi.str().c_str() );
+  check_partition_integrity(pi);
+}
+
 TEST_F(PartitionNestTest, IsEqualUnorderedFalse) {
   // check different sizes
   pi.input_string("[ 0 ]");
@@ -0,0 +1,190 @@
+/*
+ Copyright 2010 Greg Tener
+ Released under the Lesser General Public License v3.
+ */
+
+#include <nishe/BigInt.h>
+#include <nishe/PermutationGroup.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using std::vector;
+
+namespace nishe {
+
+class PermutationGroupTest: public ::testing::Test {
+ public:
+  // the permutation of n points swapping u and v
+  vector<int> transposition(int n, int u, int v) {
+    vector<int> x = identity(n);
+
+    x[u] = v;
+    x[v] = u;
+
+    return x;
+  }
+
+  // the permutation of n points taking each u to u + 1 mod n
+  vector<int> rotation(int n) {
+    vector<int> x(n);
+
+    for (int u = 0; u < n; u++) {
+      x[u] = (u + 1) % n;
+    }
+
+    return x;
+  }
+
+  vector<int> identity(int n) {
+    vector<int> x(n);
+
+    for (int u = 0; u < n; u++) {
+      x[u] = u;
+    }
+
+    return x;
+  }
+
+  BigInt factorial(int n) {
+    BigInt x(1);
+
+    for (int i = 2; i <= n; i++) {
+      x *= i;
+    }
+
+    return x;
+  }
+
+  PermutationGroup group;
+};
+
+TEST_F(PermutationGroupTest, BigInt) {
+  BigInt x(1);
+
+  EXPECT_EQ("1", x.to_string());
+
+  x *= 0;
+  EXPECT_EQ("0", x.to_string());
+
+  x = BigInt(999999999);
+  x *= 1000000001;
+  EXPECT_EQ("999999999999999999", x.to_string());
+
+  x *= 4294967295UL;
+  EXPECT_EQ("4294967294999999995705032705", x.to_string());
+
+  EXPECT_EQ("15511210043330985984000000", factorial(25).to_string());
+  EXPECT_EQ(-1, factorial(24).cmp(factorial(25)));
+  EXPECT_EQ(1, factorial(25).cmp(factorial(24)));
+  EXPECT_TRUE(factorial(25) == factorial(25));
+}
+
+TEST_F(PermutationGroupTest, Trivial) {
+  group.reset(5);
+
+  EXPECT_TRUE(group.order() == BigInt(1));
+  EXPECT_TRUE(group.contains(&identity(5)[0]));
+  EXPECT_FALSE(group.contains(&rotation(5)[0]));
+  EXPECT_FALSE(group.add_generator(&identity(5)[0]));
+}
+
+TEST_F(PermutationGroupTest, Cyclic) {
+  group.reset(12);
+
+  EXPECT_TRUE(group.add_generator(&rotation(12)[0]));
+  EXPECT_TRUE(group.order() == BigInt(12));
+
+  // a power of the rotation is already in
+  vector<int> x = rotation(12);
+  vector<int> y(12);
+
+  for (int u = 0; u < 12; u++) {
+    y[u] = x[x[x[u]]];
+  }
+
+  EXPECT_TRUE(group.contains(&y[0]));
+  EXPECT_FALSE(group.add_generator(&y[0]));
+  EXPECT_FALSE(group.contains(&transposition(12, 0, 1)[0]));
+}
+
+TEST_F(PermutationGroupTest, Symmetric) {
+  // a transposition and a rotation generate all of S_n
+  group.reset(25);
+
+  group.add_generator(&transposition(25, 0, 1)[0]);
+  group.add_generator(&rotation(25)[0]);
+
+  EXPECT_TRUE(group.order() == factorial(25));
+  EXPECT_TRUE(group.contains(&transposition(25, 3, 17)[0]));
+
+  // each basic orbit is the rest of the points
+  for (int i = 0; i < static_cast<int>(group.base().size()); i++) {
+    EXPECT_EQ(25 - i, group.basic_orbit_size(i));
+  }
+}
+
+TEST_F(PermutationGroupTest, BasePrefix) {
+  vector<int> base_prefix;
+
+  base_prefix.push_back(4);
+  base_prefix.push_back(2);
+
+  // two disjoint 3-cycles and a swap of 6 and 7
+  vector<int> x = identity(8);
+  vector<int> y = identity(8);
+  vector<int> z = transposition(8, 6, 7);
+
+  x[0] = 1;
+  x[1] = 2;
+  x[2] = 0;
+  y[3] = 4;
+  y[4] = 5;
+  y[5] = 3;
+
+  group.reset(8, base_prefix);
+  group.add_generator(&x[0]);
+  group.add_generator(&y[0]);
+  group.add_generator(&z[0]);
+
+  EXPECT_TRUE(group.order() == BigInt(18));
+  EXPECT_EQ(4, group.base()[0]);
+  EXPECT_EQ(2, group.base()[1]);
+  EXPECT_EQ(3, group.basic_orbit_size(0));
+  EXPECT_EQ(3, group.basic_orbit_size(1));
+
+  // the strong generators fixing the prefix generate its stabilizer
+  for (int g = 0; g < group.generator_count(); g++) {
+    const vector<int> &gamma = group.generator(g);
+
+    if (group.generator_level(g) >= 2) {
+      EXPECT_EQ(4, gamma[4]);
+      EXPECT_EQ(2, gamma[2]);
+    }
+  }
+}
+
+TEST_F(PermutationGroupTest, ResetRestartsRandomWalk) {
+  PermutationGroup fresh;
+
+  fresh.reset(9);
+  fresh.add_generator(&transposition(9, 0, 1)[0]);
+  fresh.add_generator(&rotation(9)[0]);
+
+  // a reset group builds the same chain as a new one
+  group.reset(9);
+  group.add_generator(&rotation(9)[0]);
+  group.reset(9);
+  group.add_generator(&transposition(9, 0, 1)[0]);
+  group.add_generator(&rotation(9)[0]);
+
+  EXPECT_TRUE(group.base() == fresh.base());
+  ASSERT_EQ(fresh.generator_count(), group.generator_count());
+
+  for (int g = 0; g < group.generator_count(); g++) {
+    EXPECT_TRUE(group.generator(g) == fresh.generator(g));
+  }
+}
+
+}  // namespace nishe
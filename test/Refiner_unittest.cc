@@ -24,6 +24,23 @@ using std::ifstream;
 
 namespace nishe {
 
+template<typename graph_t>
+static void compress(const graph_t &G, CompressedGraph<graph_t> *C_ptr) {
+  C_ptr->assign(G);
+}
+
+static void densify(const BasicGraph &G, DenseGraph *D_ptr) {
+  D_ptr->assign(G);
+}
+
+// the arc types of a directed graph as 3 edge colors
+static void color_arcs(const DirectedGraph &G, EdgeColoredGraph<3> *C_ptr) {
+  IntegerWeightedGraph weighted;
+
+  GraphIO::convert(G, &weighted);
+  GraphIO::convert(weighted, C_ptr);
+}
+
 class RefinerTest: public BaseNisheTest {
  public:
 
@@ -210,6 +227,62 @@ TEST_F(RefinerTest, IsEquitableIntegerWeightedGraph) {
   EXPECT_TRUE(is_equitable(integer_weighted_graph, pi) );
 }
 
+// sorts 0 ... n - 1 with the kernel and with a stable comparison sort
+template<typename attr_sum>
+static void expect_sorted_like_stable(const vector<attr_sum> &attr_sums) {
+  int n = attr_sums.size();
+  vector<int> cell(n);
+  vector<int> expected(n);
+  AttrSumSortBuffer buffer;
+
+  for (int i = 0; i < n; i++) {
+    cell[i] = i;
+    expected[i] = i;
+  }
+
+  sort_by_attr_sum(&cell[0], &cell[0] + n, attr_sums, &buffer);
+  std::stable_sort(expected.begin(), expected.end(),
+      AttrSumLess<attr_sum>(&attr_sums));
+
+  // the radix sorts are stable as well
+  for (int i = 0; i < n; i++) {
+    EXPECT_EQ(expected[i], cell[i]);
+  }
+}
+
+TEST_F(RefinerTest, SortByAttrSumVertex) {
+  unsigned int x = 12345;
+
+  // small enough to insertion sort, one radix pass, and several
+  for (int n = 5; n < 2000; n *= 3) {
+    vector<vertex_t> attr_sums(n);
+
+    for (int i = 0; i < n; i++) {
+      x = x * 1103515245 + 12345;
+      attr_sums[i] = (x >> 8) % (n * 50);
+    }
+
+    expect_sorted_like_stable(attr_sums);
+  }
+}
+
+TEST_F(RefinerTest, SortByAttrSumInOutBoth) {
+  unsigned int x = 12345;
+
+  for (int n = 5; n < 2000; n *= 3) {
+    vector<InOutBoth> attr_sums(n);
+
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < 3; j++) {
+        x = x * 1103515245 + 12345;
+        attr_sums[i].weights[j] = (x >> 8) % (j == 1 ? 1000 : 4);
+      }
+    }
+
+    expect_sorted_like_stable(attr_sums);
+  }
+}
+
 TEST_F(RefinerTest, RefineSmallGreater) {
   RefineTraceValue<BasicGraph> a;
   Refiner<BasicGraph> refiner;
@@ -259,6 +332,377 @@ TEST_F(RefinerTest, RefineDirectedSmall) {
   verify_equitibility<DirectedGraph>("test/data/directed-1-5.txt");
 }
 
+TEST_F(RefinerTest, RefineCompressedBasicSmall) {
+  verify_converted_equitibility<BasicGraph, CompressedGraph<BasicGraph> >
+    ("test/data/undirected-1-7.txt", compress);
+}
+
+TEST_F(RefinerTest, RefineCompressedDirectedSmall) {
+  verify_converted_equitibility<DirectedGraph,
+    CompressedGraph<DirectedGraph> >("test/data/directed-1-5.txt", compress);
+}
+
+TEST_F(RefinerTest, RefinePackedDirectedSmall) {
+  verify_converted_equitibility<DirectedGraph, PackedDirectedGraph>
+    ("test/data/directed-1-5.txt", GraphIO::convert);
+}
+
+TEST_F(RefinerTest, RefineDenseSmall) {
+  verify_converted_equitibility<BasicGraph, DenseGraph>
+    ("test/data/undirected-1-7.txt", densify);
+}
+
+// big enough that most cells are sown with the bit rows
+TEST_F(RefinerTest, RefineDenseMatchesBasic) {
+  unsigned int x = 12345;
+
+  for (int u = 0; u < 300; u++) {
+    for (int v = u + 1; v < 300; v++) {
+      x = x * 1103515245 + 12345;
+
+      // about 3 / 4 of the edges
+      if ((x >> 16) % 4 != 0) {
+        basic_graph.add_edge(u, v);
+      }
+    }
+  }
+
+  DenseGraph dense_graph(basic_graph);
+  PartitionNest dense_pi;
+
+  RefineTraceValue<BasicGraph> trace;
+  RefineTraceValue<DenseGraph> dense_trace;
+  Refiner<BasicGraph> refiner;
+  Refiner<DenseGraph> dense_refiner;
+
+  for (int u = 0; u < 300; u += 37) {
+    pi.unit(300);
+    pi.advance_level();
+    pi.breakout(u);
+    dense_pi.input_string(pi.str() );
+
+    trace.clear();
+    dense_trace.clear();
+    refiner.refine(basic_graph, &pi, &trace, 0);
+    dense_refiner.refine(dense_graph, &dense_pi, &dense_trace, 0);
+
+    EXPECT_STREQ(pi.str().c_str(), dense_pi.str().c_str() );
+    EXPECT_TRUE(is_equitable(dense_graph, dense_pi) );
+  }
+}
+
+TEST_F(RefinerTest, RefineSkipLargest) {
+  unsigned int x = 12345;
+
+  for (int u = 0; u < 300; u++) {
+    for (int i = 0; i < 3; i++) {
+      x = x * 1103515245 + 12345;
+      basic_graph.add_edge(u, (x >> 8) % 300);
+    }
+  }
+
+  PartitionNest skip_pi;
+  PartitionNest start_pi;
+
+  RefineTraceValue<BasicGraph> trace;
+  RefineTraceValue<BasicGraph> skip_trace;
+  Refiner<BasicGraph> refiner;
+  Refiner<BasicGraph> skip_refiner;
+
+  skip_refiner.set_skip_largest(true);
+
+  for (int u = 0; u < 300; u += 37) {
+    pi.unit(300);
+    pi.advance_level();
+    pi.breakout(u);
+    start_pi.input_string(pi.str() );
+    skip_pi.input_string(pi.str() );
+
+    trace.clear();
+    skip_trace.clear();
+    refiner.refine(basic_graph, &pi, &trace, 0);
+    skip_refiner.refine(basic_graph, &skip_pi, &skip_trace, 0);
+
+    // the same coarsest equitable partition either way
+    EXPECT_TRUE(is_equitable(basic_graph, skip_pi) );
+    EXPECT_TRUE(pi.is_equal_unordered(skip_pi) );
+
+    // and refining again follows the trace exactly
+    EXPECT_EQ(0, skip_refiner.refine(basic_graph, &start_pi, &skip_trace, 0) );
+    EXPECT_STREQ(skip_pi.str().c_str(), start_pi.str().c_str() );
+  }
+}
+
+TEST_F(RefinerTest, RefineWorkspaceTrim) {
+  RefineTraceValue<BasicGraph> a;
+  RefineTraceValue<BasicGraph> b;
+  Refiner<BasicGraph> refiner;
+  PartitionNest pi2;
+
+  GraphIO::path(&basic_graph, &pi, 50);
+  pi2.input_string(pi.str() );
+
+  refiner.get_workspace().reserve(20);
+  EXPECT_EQ(20, refiner.get_workspace().capacity() );
+
+  // grows to the graph
+  refiner.refine(basic_graph, &pi, &a);
+  EXPECT_EQ(50, refiner.get_workspace().capacity() );
+
+  // but not back down on its own
+  refiner.get_workspace().reserve(10);
+  EXPECT_EQ(50, refiner.get_workspace().capacity() );
+
+  refiner.get_workspace().trim();
+  EXPECT_EQ(0, refiner.get_workspace().capacity() );
+
+  refiner.refine(basic_graph, &pi2, &b);
+  EXPECT_STREQ(pi.str().c_str(), pi2.str().c_str() );
+  EXPECT_EQ(0, a.cmp(b) );
+}
+
+TEST_F(RefinerTest, ActiveIndicesOrders) {
+  ActiveIndices::Order orders[] = {ActiveIndices::LIFO, ActiveIndices::FIFO,
+      ActiveIndices::SMALLEST_FIRST};
+  int expected[][4] = {{7, 2, 5, 0}, {0, 5, 2, 7}, {2, 5, 7, 0}};
+
+  for (int i = 0; i < 3; i++) {
+    ActiveIndices active;
+
+    active.set_order(orders[i]);
+    active.resize(10);
+
+    active.push(0, 4);
+    active.push(5, 3);
+    active.push(2, 3);
+    active.push(5, 3);  // already queued
+    active.push(7, 2);
+    active.push(5, 1);  // 5 was split, only changes SMALLEST_FIRST
+    active.push(2, 1);
+
+    EXPECT_EQ(4, active.size() );
+    EXPECT_TRUE(active.contains(5) );
+
+    for (int j = 0; j < 4; j++) {
+      EXPECT_EQ(expected[i][j], active.pop() );
+    }
+
+    EXPECT_TRUE(active.empty() );
+    EXPECT_FALSE(active.contains(5) );
+  }
+}
+
+TEST_F(RefinerTest, RefineOrders) {
+  unsigned int x = 12345;
+
+  for (int u = 0; u < 300; u++) {
+    for (int i = 0; i < 3; i++) {
+      x = x * 1103515245 + 12345;
+      basic_graph.add_edge(u, (x >> 8) % 300);
+    }
+  }
+
+  ActiveIndices::Order orders[] = {ActiveIndices::FIFO,
+      ActiveIndices::SMALLEST_FIRST};
+
+  PartitionNest order_pi;
+  PartitionNest start_pi;
+
+  RefineTraceValue<BasicGraph> trace;
+  Refiner<BasicGraph> refiner;
+
+  for (int i = 0; i < 4; i++) {
+    Refiner<BasicGraph> order_refiner;
+    RefineTraceValue<BasicGraph> order_trace;
+
+    order_refiner.set_order(orders[i % 2]);
+    order_refiner.set_skip_largest(i >= 2);
+
+    pi.unit(300);
+    pi.advance_level();
+    pi.breakout(37 * i);
+    start_pi.input_string(pi.str() );
+    order_pi.input_string(pi.str() );
+
+    trace.clear();
+    refiner.refine(basic_graph, &pi, &trace, 0);
+    order_refiner.refine(basic_graph, &order_pi, &order_trace, 0);
+
+    EXPECT_TRUE(is_equitable(basic_graph, order_pi) );
+    EXPECT_TRUE(pi.is_equal_unordered(order_pi) );
+
+    EXPECT_EQ(0, order_refiner.refine(basic_graph, &start_pi, &order_trace, 0) );
+    EXPECT_STREQ(order_pi.str().c_str(), start_pi.str().c_str() );
+  }
+}
+
+// refines G after breaking out u, returning the comparison to the trace
+template<typename trace_t>
+static int refine_from(const BasicGraph &G, int u, trace_t *trace_ptr,
+    PartitionNest *pi_ptr) {
+  Refiner<BasicGraph, trace_t> refiner;
+
+  pi_ptr->unit(G.vertex_count() );
+  pi_ptr->advance_level();
+  pi_ptr->breakout(u);
+
+  return refiner.refine(G, pi_ptr, trace_ptr, 0);
+}
+
+TEST_F(RefinerTest, RefineTraceHash) {
+  unsigned int x = 12345;
+
+  for (int u = 0; u < 200; u++) {
+    for (int i = 0; i < 2; i++) {
+      x = x * 1103515245 + 12345;
+      basic_graph.add_edge(u, (x >> 8) % 200);
+    }
+  }
+
+  vector<RefineTraceHash<BasicGraph> > traces(10);
+  vector<RefineTraceHash<BasicGraph> > full_traces(10);
+  PartitionNest hash_pi;
+
+  for (int i = 0; i < 10; i++) {
+    RefineTraceValue<BasicGraph> trace;
+
+    full_traces[i].set_keep_full(true);
+
+    refine_from(basic_graph, 17 * i, &trace, &pi);
+    refine_from(basic_graph, 17 * i, &traces[i], &hash_pi);
+    refine_from(basic_graph, 17 * i, &full_traces[i], &hash_pi);
+
+    // the same partition as with a full trace
+    EXPECT_STREQ(pi.str().c_str(), hash_pi.str().c_str() );
+    EXPECT_EQ(trace.active_indices.size(), traces[i].size() );
+  }
+
+  for (int i = 0; i < 10; i++) {
+    for (int j = 0; j < 10; j++) {
+      RefineTraceHash<BasicGraph> trace = traces[j];
+      int expected = traces[i].cmp(traces[j]);
+
+      // refining against a trace agrees with comparing the two traces
+      EXPECT_EQ(expected, refine_from(basic_graph, 17 * i, &trace, &hash_pi));
+
+      // and a smaller refinement replaces the trace
+      if (expected == -1) {
+        EXPECT_EQ(0, traces[i].cmp(trace) );
+      }
+
+      EXPECT_EQ(expected == 0, traces[i].hash() == traces[j].hash() );
+      EXPECT_EQ(expected == 0, full_traces[i].cmp(full_traces[j]) == 0);
+    }
+  }
+}
+
+TEST_F(RefinerTest, FlatRefineTrace) {
+  unsigned int x = 54321;
+
+  for (int u = 0; u < 200; u++) {
+    for (int i = 0; i < 2; i++) {
+      x = x * 1103515245 + 12345;
+      basic_graph.add_edge(u, (x >> 8) % 200);
+    }
+  }
+
+  vector<RefineTraceValue<BasicGraph> > value_traces(10);
+  vector<FlatRefineTrace<BasicGraph> > flat_traces(10);
+  PartitionNest flat_pi;
+
+  for (int i = 0; i < 10; i++) {
+    PartitionNest pi;
+
+    refine_from(basic_graph, 17 * i, &value_traces[i], &pi);
+    refine_from(basic_graph, 17 * i, &flat_traces[i], &flat_pi);
+
+    EXPECT_STREQ(pi.str().c_str(), flat_pi.str().c_str() );
+    EXPECT_EQ(value_traces[i].active_indices.size(), flat_traces[i].size() );
+  }
+
+  for (int i = 0; i < 10; i++) {
+    for (int j = 0; j < 10; j++) {
+      FlatRefineTrace<BasicGraph> trace = flat_traces[j];
+      int expected = value_traces[i].cmp(value_traces[j]);
+
+      // ordered just like the full traces
+      EXPECT_EQ(expected, flat_traces[i].cmp(flat_traces[j]) );
+      EXPECT_EQ(expected, refine_from(basic_graph, 17 * i, &trace, &flat_pi));
+
+      // a smaller refinement replaces the trace in place
+      if (expected == -1) {
+        EXPECT_EQ(0, flat_traces[i].cmp(trace) );
+        EXPECT_EQ(flat_traces[i].size(), trace.size() );
+      }
+    }
+  }
+}
+
+typedef RefinerTest RefinerDeathTest;
+
+// the top two bits of a 32 bit record say what it holds
+TEST_F(RefinerDeathTest, FlatRefineTraceIndexTooLarge) {
+  FlatRefineTrace<BasicGraph> trace;
+  int cmp = -1;
+
+  if (sizeof(FlatRefineTrace<BasicGraph>::word) == 4) {
+    EXPECT_DEATH(trace.trace_active_index(1 << 30, 0, &cmp),
+        "Error Error Examine: index 1073741825 is too large for a trace");
+    EXPECT_DEATH(trace.trace_invariant(0, 1 << 30, 0, 0, &cmp),
+        "Error Error Examine: index 1073741824 is too large for a trace");
+  }
+
+  EXPECT_DEATH(trace.trace_invariant(0, -1, 0, 0, &cmp),
+      "Error Error Examine: index -1 is too large for a trace");
+}
+
+TEST_F(RefinerTest, RefineInvariants) {
+  VertexInvariant invariants[] = {TRIANGLES, DISTANCES, CLIQUES, QUADRUPLES};
+  int args[] = {0, 0, 3, 0};
+  PartitionNest expected;
+
+  // a triangle and a square, 2-regular so refining alone can't split it
+  GraphIO::input_list_ascii("0 : 1 2 ;\n1 : 0 2 ;\n2 : 0 1 ;\n"
+      "3 : 4 6 ;\n4 : 3 5 ;\n5 : 4 6 ;\n6 : 3 5 ;", &basic_graph, &pi);
+  expected.input_string("[ 0 1 2 | 3 4 5 6 ]");
+
+  for (int i = 0; i < 4; i++) {
+    Refiner<BasicGraph> refiner;
+    RefineTraceValue<BasicGraph> trace;
+    FlatRefineTrace<BasicGraph> flat_trace;
+
+    pi.unit(7);
+    refiner.refine(basic_graph, &pi, &trace);
+    EXPECT_EQ(1, pi.length() );
+
+    refiner.set_invariant(invariants[i], args[i]);
+    trace.clear();
+
+    pi.unit(7);
+    refiner.refine(basic_graph, &pi, &trace);
+    EXPECT_TRUE(pi.is_equal_unordered(expected) );
+    EXPECT_EQ(Refiner<BasicGraph>::INVARIANT_INDEX, trace.active_indices[1]);
+
+    // the invariant step is traced like any other
+    pi.unit(7);
+    EXPECT_EQ(0, refiner.refine(basic_graph, &pi, &trace) );
+
+    Refiner<BasicGraph, FlatRefineTrace<BasicGraph> > flat_refiner;
+
+    flat_refiner.set_invariant(invariants[i], args[i]);
+    pi.unit(7);
+    flat_refiner.refine(basic_graph, &pi, &flat_trace);
+    pi.unit(7);
+    EXPECT_EQ(0, flat_refiner.refine(basic_graph, &pi, &flat_trace) );
+    EXPECT_EQ(trace.active_indices.size(), flat_trace.size() );
+  }
+}
+
+TEST_F(RefinerTest, RefineEdgeColoredSmall) {
+  verify_converted_equitibility<DirectedGraph, EdgeColoredGraph<3> >
+    ("test/data/directed-1-5.txt", color_arcs);
+}
+
 TEST_F(RefinerTest, RefineIntegerWeightedSmall) {
   verify_converted_equitibility<DirectedGraph, IntegerWeightedGraph>
     ("test/data/directed-1-5.txt", GraphIO::convert);